@@ -1,20 +1,470 @@
 #include <iostream>
 #include <vector>
+#include <chrono>
+#include <thread>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <random>
 #include "SDL.h"
 
+// x86 builds get SSE/AVX ball kernels, picked at runtime from what the CPU has
+// (GCC/Clang compile each kernel for its own instruction set, MSVC doesn't need telling)
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PONG_SIMD 1
+#if defined(__GNUC__) || defined(__clang__)
+#define PONG_TARGET(isa) __attribute__((target(isa)))
+#else
+#define PONG_TARGET(isa)
+#endif
+#else
+#define PONG_SIMD 0
+#endif
+
 struct Vector2 {
     float x;
     float y;
 };
 
-struct Ball {
-    Vector2 position;
-    Vector2 velocity;
+// Frame limiter that sleeps for most of the frame instead of busy-waiting.
+// Only the last fraction of a millisecond is spun to hit the deadline.
+class FramePacer {
+public:
+    // Target frame rate (0 for uncapped)
+    void SetTargetFPS(float fps) { mTargetFPS = fps > 0.0f ? fps : 0.0f; }
+    // Restart the frame clock
+    void Reset() {
+        mLastFrame = Clock::now();
+        mFrames = 0;
+        mAvgFrameTime = 0.0;
+        mFrameTimeM2 = 0.0;
+        mSleepTime = 0.0;
+    }
+    // Wait until the next frame is due, returns seconds since the last frame
+    float WaitForNextFrame();
+    // Log frame time jitter and the time spent asleep
+    void LogStats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point mLastFrame = Clock::now();
+    float mTargetFPS = 60.0f;
+    // How close to the deadline we switch from sleeping to spinning (seconds)
+    double mSpinThreshold = 0.0005;
+
+    // Stats
+    int mFrames = 0;
+    double mAvgFrameTime = 0.0;
+    double mFrameTimeM2 = 0.0;
+    double mSleepTime = 0.0;
+};
+
+float FramePacer::WaitForNextFrame() {
+    if (mTargetFPS > 0.0f) {
+        auto deadline = mLastFrame + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(1.0 / mTargetFPS));
+        auto spinFrom = deadline - std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(mSpinThreshold));
+
+        // Sleep through most of the remaining time
+        auto now = Clock::now();
+        if (now < spinFrom) {
+            std::this_thread::sleep_for(spinFrom - now);
+            auto woke = Clock::now();
+            mSleepTime += std::chrono::duration<double>(woke - now).count();
+        }
+
+        // Spin for whatever is left
+        while (Clock::now() < deadline)
+            ;
+    }
+
+    auto now = Clock::now();
+    double frameTime = std::chrono::duration<double>(now - mLastFrame).count();
+    mLastFrame = now;
+
+    // Running mean/variance of frame time (Welford)
+    mFrames++;
+    double delta = frameTime - mAvgFrameTime;
+    mAvgFrameTime += delta / mFrames;
+    mFrameTimeM2 += delta * (frameTime - mAvgFrameTime);
+
+    return static_cast<float>(frameTime);
+}
+
+void FramePacer::LogStats() const {
+    if (mFrames == 0) {
+        return;
+    }
+
+    double total = mAvgFrameTime * mFrames;
+    SDL_Log("FramePacer: %d frames, avg %.3f ms, jitter %.3f ms, slept %.1f%% of the run",
+        mFrames,
+        mAvgFrameTime * 1000.0,
+        std::sqrt(mFrameTimeM2 / mFrames) * 1000.0,
+        total > 0.0 ? 100.0 * mSleepTime / total : 0.0
+    );
+}
+
+const int THICKNESS = 15;
+const int PADDLE_H = 150;
+const float FIELD_W = 1024.0f;
+const float FIELD_H = 768.0f;
+
+// Every ball in the game, stored as structure of arrays so the update can
+// run 4 (SSE) or 8 (AVX) balls at a time, with a scalar loop for the rest
+class BallSystem {
+public:
+    enum Kernel {
+        EScalar,
+        ESSE,
+        EAVX
+    };
+
+    BallSystem() : mKernel(BestKernel()) {}
+
+    // Widest kernel this build and CPU can run
+    static Kernel BestKernel();
+    static const char* KernelName(Kernel kernel);
+    // Falls back to the best supported kernel if this one isn't
+    void SetKernel(Kernel kernel) { mKernel = kernel <= BestKernel() ? kernel : BestKernel(); }
+    Kernel GetKernel() const { return mKernel; }
+
+    void Clear();
+    void Add(const Vector2& pos, const Vector2& vel);
+    // The classic serve plus count - 1 random balls (same seed, same balls)
+    void Spawn(int count, unsigned seed = 1234);
+    int Size() const { return static_cast<int>(mPosX.size()); }
+
+    // Move every ball, bouncing off the walls and paddles
+    void Update(float deltaTime, const Vector2& paddleL, const Vector2& paddleR);
+    // Remember where the balls are before a step, for drawing between steps
+    void SavePrevious();
+
+    // Structure of arrays, index i is ball i
+    std::vector<float> mPosX;
+    std::vector<float> mPosY;
+    std::vector<float> mVelX;
+    std::vector<float> mVelY;
+    // Positions before the last step
+    std::vector<float> mPrevX;
+    std::vector<float> mPrevY;
+
+private:
+    // Each kernel updates balls [begin, end), the SIMD ones leave the tail
+    // that doesn't fill a register and return where they stopped
+    void UpdateScalar(int begin, int end, float deltaTime, float paddleLY, float paddleRY);
+#if PONG_SIMD
+    int UpdateSSE(int end, float deltaTime, float paddleLY, float paddleRY);
+    int UpdateAVX(int end, float deltaTime, float paddleLY, float paddleRY);
+#endif
+
+    Kernel mKernel;
 };
 
+BallSystem::Kernel BallSystem::BestKernel() {
+#if PONG_SIMD
+    if (SDL_HasAVX()) {
+        return EAVX;
+    }
+    if (SDL_HasSSE()) {
+        return ESSE;
+    }
+#endif
+    return EScalar;
+}
+
+const char* BallSystem::KernelName(Kernel kernel) {
+    switch (kernel) {
+        case EAVX:
+            return "AVX";
+        case ESSE:
+            return "SSE";
+        default:
+            return "scalar";
+    }
+}
+
+void BallSystem::Clear() {
+    mPosX.clear();
+    mPosY.clear();
+    mVelX.clear();
+    mVelY.clear();
+    mPrevX.clear();
+    mPrevY.clear();
+}
+
+void BallSystem::Add(const Vector2& pos, const Vector2& vel) {
+    mPosX.push_back(pos.x);
+    mPosY.push_back(pos.y);
+    mVelX.push_back(vel.x);
+    mVelY.push_back(vel.y);
+    mPrevX.push_back(pos.x);
+    mPrevY.push_back(pos.y);
+}
+
+void BallSystem::SavePrevious() {
+    mPrevX.assign(mPosX.begin(), mPosX.end());
+    mPrevY.assign(mPosY.begin(), mPosY.end());
+}
+
+void BallSystem::Spawn(int count, unsigned seed) {
+    Clear();
+    mPosX.reserve(count);
+    mPosY.reserve(count);
+    mVelX.reserve(count);
+    mVelY.reserve(count);
+    mPrevX.reserve(count);
+    mPrevY.reserve(count);
+
+    if (count > 0) {
+        Add({ 512, 384 }, { -200.0f, 235.0f });
+    }
+
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> posX(100.0f, FIELD_W - 100.0f);
+    std::uniform_real_distribution<float> posY(THICKNESS * 2.0f, FIELD_H - THICKNESS * 2.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+    std::uniform_real_distribution<float> speed(150.0f, 350.0f);
+    for (int i = 1; i < count; i++) {
+        float a = angle(random);
+        float v = speed(random);
+        Add({ posX(random), posY(random) }, { std::cos(a) * v, std::sin(a) * v });
+    }
+}
+
+void BallSystem::Update(float deltaTime, const Vector2& paddleL, const Vector2& paddleR) {
+    int count = Size();
+    int done = 0;
+
+#if PONG_SIMD
+    if (mKernel == EAVX) {
+        done = UpdateAVX(count, deltaTime, paddleL.y, paddleR.y);
+    }
+    else if (mKernel == ESSE) {
+        done = UpdateSSE(count, deltaTime, paddleL.y, paddleR.y);
+    }
+#endif
+
+    UpdateScalar(done, count, deltaTime, paddleL.y, paddleR.y);
+}
+
+void BallSystem::UpdateScalar(int begin, int end, float deltaTime, float paddleLY, float paddleRY) {
+    for (int i = begin; i < end; i++) {
+        // Update ball x & y position
+        float x = mPosX[i] + mVelX[i] * deltaTime;
+        float y = mPosY[i] + mVelY[i] * deltaTime;
+        float vx = mVelX[i];
+        float vy = mVelY[i];
+
+        if (y <= THICKNESS && vy < 0.0f) {
+            vy *= -1;
+        }
+        else if (y >= (FIELD_H - THICKNESS) && vy > 0.0f) {
+            vy *= -1;
+        }
+
+        if (x <= THICKNESS && vx < 0.0f) {
+            vx *= -1;
+        }
+        else if (x >= (FIELD_W - THICKNESS) && vx > 0.0f) {
+            vx *= -1;
+        }
+
+        float diffL = std::fabs(paddleLY - y);
+        float diffR = std::fabs(paddleRY - y);
+
+        // Moving left, at the left paddle's x and within its height
+        if (diffL <= PADDLE_H / 2.0f && x <= 60.0f && x >= 55.0f && vx <= 0.0f) {
+            vx *= -1.0f;
+        }
+
+        // Moving right, at the right paddle's x and within its height
+        if (diffR <= PADDLE_H / 2.0f && x <= 969.0f && x >= 964.0f && vx >= 0.0f) {
+            vx *= -1.0f;
+        }
+
+        mPosX[i] = x;
+        mPosY[i] = y;
+        mVelX[i] = vx;
+        mVelY[i] = vy;
+    }
+}
+
+#if PONG_SIMD
+// Same tests as UpdateScalar as lane masks. A bounce flips the sign bit of the
+// velocity (exactly what *= -1 does), and the x bounces happen at different x
+// ranges so they can all be or'd into one mask.
+PONG_TARGET("sse")
+int BallSystem::UpdateSSE(int end, float deltaTime, float paddleLY, float paddleRY) {
+    const __m128 dt = _mm_set1_ps(deltaTime);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    const __m128 top = _mm_set1_ps(static_cast<float>(THICKNESS));
+    const __m128 bottom = _mm_set1_ps(FIELD_H - THICKNESS);
+    const __m128 left = _mm_set1_ps(static_cast<float>(THICKNESS));
+    const __m128 right = _mm_set1_ps(FIELD_W - THICKNESS);
+    const __m128 halfPaddle = _mm_set1_ps(PADDLE_H / 2.0f);
+    const __m128 paddleL = _mm_set1_ps(paddleLY);
+    const __m128 paddleR = _mm_set1_ps(paddleRY);
+    const __m128 paddleLMin = _mm_set1_ps(55.0f);
+    const __m128 paddleLMax = _mm_set1_ps(60.0f);
+    const __m128 paddleRMin = _mm_set1_ps(964.0f);
+    const __m128 paddleRMax = _mm_set1_ps(969.0f);
+
+    float* posX = mPosX.data();
+    float* posY = mPosY.data();
+    float* velX = mVelX.data();
+    float* velY = mVelY.data();
+
+    int i = 0;
+    for (; i + 4 <= end; i += 4) {
+        __m128 vx = _mm_loadu_ps(velX + i);
+        __m128 vy = _mm_loadu_ps(velY + i);
+        __m128 x = _mm_add_ps(_mm_loadu_ps(posX + i), _mm_mul_ps(vx, dt));
+        __m128 y = _mm_add_ps(_mm_loadu_ps(posY + i), _mm_mul_ps(vy, dt));
+
+        __m128 flipY = _mm_or_ps(
+            _mm_and_ps(_mm_cmple_ps(y, top), _mm_cmplt_ps(vy, zero)),
+            _mm_and_ps(_mm_cmpge_ps(y, bottom), _mm_cmpgt_ps(vy, zero)));
+
+        __m128 flipX = _mm_or_ps(
+            _mm_and_ps(_mm_cmple_ps(x, left), _mm_cmplt_ps(vx, zero)),
+            _mm_and_ps(_mm_cmpge_ps(x, right), _mm_cmpgt_ps(vx, zero)));
+
+        __m128 diffL = _mm_andnot_ps(signBit, _mm_sub_ps(paddleL, y));
+        __m128 hitL = _mm_and_ps(
+            _mm_and_ps(_mm_cmple_ps(diffL, halfPaddle), _mm_cmple_ps(vx, zero)),
+            _mm_and_ps(_mm_cmple_ps(x, paddleLMax), _mm_cmpge_ps(x, paddleLMin)));
+
+        __m128 diffR = _mm_andnot_ps(signBit, _mm_sub_ps(paddleR, y));
+        __m128 hitR = _mm_and_ps(
+            _mm_and_ps(_mm_cmple_ps(diffR, halfPaddle), _mm_cmpge_ps(vx, zero)),
+            _mm_and_ps(_mm_cmple_ps(x, paddleRMax), _mm_cmpge_ps(x, paddleRMin)));
+
+        flipX = _mm_or_ps(flipX, _mm_or_ps(hitL, hitR));
+
+        _mm_storeu_ps(posX + i, x);
+        _mm_storeu_ps(posY + i, y);
+        _mm_storeu_ps(velX + i, _mm_xor_ps(vx, _mm_and_ps(flipX, signBit)));
+        _mm_storeu_ps(velY + i, _mm_xor_ps(vy, _mm_and_ps(flipY, signBit)));
+    }
+
+    return i;
+}
+
+PONG_TARGET("avx")
+int BallSystem::UpdateAVX(int end, float deltaTime, float paddleLY, float paddleRY) {
+    const __m256 dt = _mm256_set1_ps(deltaTime);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 signBit = _mm256_set1_ps(-0.0f);
+    const __m256 top = _mm256_set1_ps(static_cast<float>(THICKNESS));
+    const __m256 bottom = _mm256_set1_ps(FIELD_H - THICKNESS);
+    const __m256 left = _mm256_set1_ps(static_cast<float>(THICKNESS));
+    const __m256 right = _mm256_set1_ps(FIELD_W - THICKNESS);
+    const __m256 halfPaddle = _mm256_set1_ps(PADDLE_H / 2.0f);
+    const __m256 paddleL = _mm256_set1_ps(paddleLY);
+    const __m256 paddleR = _mm256_set1_ps(paddleRY);
+    const __m256 paddleLMin = _mm256_set1_ps(55.0f);
+    const __m256 paddleLMax = _mm256_set1_ps(60.0f);
+    const __m256 paddleRMin = _mm256_set1_ps(964.0f);
+    const __m256 paddleRMax = _mm256_set1_ps(969.0f);
+
+    float* posX = mPosX.data();
+    float* posY = mPosY.data();
+    float* velX = mVelX.data();
+    float* velY = mVelY.data();
+
+    int i = 0;
+    for (; i + 8 <= end; i += 8) {
+        __m256 vx = _mm256_loadu_ps(velX + i);
+        __m256 vy = _mm256_loadu_ps(velY + i);
+        __m256 x = _mm256_add_ps(_mm256_loadu_ps(posX + i), _mm256_mul_ps(vx, dt));
+        __m256 y = _mm256_add_ps(_mm256_loadu_ps(posY + i), _mm256_mul_ps(vy, dt));
+
+        __m256 flipY = _mm256_or_ps(
+            _mm256_and_ps(_mm256_cmp_ps(y, top, _CMP_LE_OQ), _mm256_cmp_ps(vy, zero, _CMP_LT_OQ)),
+            _mm256_and_ps(_mm256_cmp_ps(y, bottom, _CMP_GE_OQ), _mm256_cmp_ps(vy, zero, _CMP_GT_OQ)));
+
+        __m256 flipX = _mm256_or_ps(
+            _mm256_and_ps(_mm256_cmp_ps(x, left, _CMP_LE_OQ), _mm256_cmp_ps(vx, zero, _CMP_LT_OQ)),
+            _mm256_and_ps(_mm256_cmp_ps(x, right, _CMP_GE_OQ), _mm256_cmp_ps(vx, zero, _CMP_GT_OQ)));
+
+        __m256 diffL = _mm256_andnot_ps(signBit, _mm256_sub_ps(paddleL, y));
+        __m256 hitL = _mm256_and_ps(
+            _mm256_and_ps(_mm256_cmp_ps(diffL, halfPaddle, _CMP_LE_OQ), _mm256_cmp_ps(vx, zero, _CMP_LE_OQ)),
+            _mm256_and_ps(_mm256_cmp_ps(x, paddleLMax, _CMP_LE_OQ), _mm256_cmp_ps(x, paddleLMin, _CMP_GE_OQ)));
+
+        __m256 diffR = _mm256_andnot_ps(signBit, _mm256_sub_ps(paddleR, y));
+        __m256 hitR = _mm256_and_ps(
+            _mm256_and_ps(_mm256_cmp_ps(diffR, halfPaddle, _CMP_LE_OQ), _mm256_cmp_ps(vx, zero, _CMP_GE_OQ)),
+            _mm256_and_ps(_mm256_cmp_ps(x, paddleRMax, _CMP_LE_OQ), _mm256_cmp_ps(x, paddleRMin, _CMP_GE_OQ)));
+
+        flipX = _mm256_or_ps(flipX, _mm256_or_ps(hitL, hitR));
+
+        _mm256_storeu_ps(posX + i, x);
+        _mm256_storeu_ps(posY + i, y);
+        _mm256_storeu_ps(velX + i, _mm256_xor_ps(vx, _mm256_and_ps(flipX, signBit)));
+        _mm256_storeu_ps(velY + i, _mm256_xor_ps(vy, _mm256_and_ps(flipY, signBit)));
+    }
+
+    return i;
+}
+#endif
+
+// Headless ball throughput for each kernel the CPU supports (--bench [balls])
+void BenchmarkBalls(int count, int frames) {
+    const float deltaTime = 1.0f / 60.0f;
+    const Vector2 paddleL{ 50, 384 };
+    const Vector2 paddleR{ 974, 384 };
+
+    BallSystem reference;
+    reference.SetKernel(BallSystem::EScalar);
+
+    for (int k = BallSystem::EScalar; k <= BallSystem::BestKernel(); k++) {
+        BallSystem balls;
+        balls.SetKernel(static_cast<BallSystem::Kernel>(k));
+        balls.Spawn(count);
+
+        Uint64 start = SDL_GetPerformanceCounter();
+        for (int frame = 0; frame < frames; frame++) {
+            balls.Update(deltaTime, paddleL, paddleR);
+        }
+        double seconds = static_cast<double>(SDL_GetPerformanceCounter() - start)
+            / SDL_GetPerformanceFrequency();
+
+        // Every kernel should end up exactly where the scalar one did
+        if (k == BallSystem::EScalar) {
+            reference = balls;
+        }
+        int mismatches = 0;
+        for (int i = 0; i < count; i++) {
+            if (balls.mPosX[i] != reference.mPosX[i] || balls.mPosY[i] != reference.mPosY[i]) {
+                mismatches++;
+            }
+        }
+
+        double updates = static_cast<double>(count) * frames;
+        SDL_Log("[bench] BallUpdate %-6s %7d balls x %d frames: %8.1f M balls/s, %.2f ns/ball, %d differ from scalar",
+            BallSystem::KernelName(static_cast<BallSystem::Kernel>(k)),
+            count,
+            frames,
+            seconds > 0.0 ? updates / seconds / 1e6 : 0.0,
+            seconds * 1e9 / updates,
+            mismatches
+        );
+    }
+}
+
 class Game {
 public:
     Game();
+    // Replace the balls with count of them (before or during play)
+    void SetNumBalls(int count) { mBalls.Spawn(count); }
+    // Fixed simulation steps per second, whatever the frame rate
+    void SetSimRate(float hz) { mSimStep = 1.0f / hz; }
     // Initialise the game
     bool Initialise();
     // Run the game loop until the game is over
@@ -26,6 +476,8 @@ private:
     // Helper functions for the game loop
     void ProcessInput();
     void UpdateGame();
+    // One fixed step of the paddles and balls
+    void StepSimulation(float deltaTime);
     void GenerateOutput();
 
     // Window created by SDL
@@ -35,20 +487,30 @@ private:
     // Should the game run
     bool mIsRunning;
 
-    const int THICKNESS = 15;
-    const int PADDLE_H = 150.0f;
-
     Vector2 mPaddlePos;
     Vector2 mPaddleRPos;
     int mPaddleDir;
     int mPaddleRDir;
-
-    Vector2 mBallPos;
-    Vector2 mBallVel;
-
-    std::vector<Ball> balls;
-
-    Uint32 mTicksCount;
+    // Paddle heights before the last step
+    float mPaddlePrevY;
+    float mPaddleRPrevY;
+
+    // Fixed step simulation
+    float mSimStep;
+    // Frame time not yet simulated
+    float mAccumulator;
+    // How far between the last two steps to draw (0 to 1)
+    float mInterpolation;
+    // Behind on steps, don't draw this frame
+    bool mSkipRender;
+    int mSkippedInARow;
+
+    BallSystem mBalls;
+    // Reused every frame to draw the balls in one call
+    std::vector<SDL_Rect> mBallRects;
+
+    // Limits the frame rate and measures delta time
+    FramePacer mPacer;
 };
 
 Game::Game() {
@@ -57,13 +519,16 @@ Game::Game() {
     
     mPaddlePos = { 50, 384 };
     mPaddleRPos = { 974, 384 };
+    mPaddlePrevY = mPaddlePos.y;
+    mPaddleRPrevY = mPaddleRPos.y;
 
-    mBallPos = { 512, 384 };
-    mBallVel = { -200.0f, 235.0f };
+    mSimStep = 1.0f / 60.0f;
+    mAccumulator = 0.0f;
+    mInterpolation = 1.0f;
+    mSkipRender = false;
+    mSkippedInARow = 0;
 
-    balls.push_back(Ball());
-
-    mTicksCount = 0;
+    mBalls.Spawn(1);
 }
 
 bool Game::Initialise() {
@@ -99,6 +564,10 @@ bool Game::Initialise() {
         return false;
     }
 
+    mPacer.Reset();
+
+    SDL_Log("Pong: %d balls, %s ball update", mBalls.Size(), BallSystem::KernelName(mBalls.GetKernel()));
+
     return true;
 }
 
@@ -112,6 +581,7 @@ void Game::RunLoop() {
 }
 
 void Game::Shutdown() {
+    mPacer.LogStats();
     SDL_DestroyWindow(mWindow);
     SDL_DestroyRenderer(mRenderer);
     SDL_Quit();
@@ -160,22 +630,49 @@ void Game::ProcessInput() {
 }
 
 void Game::UpdateGame() {
-    // Wait until 16ms has elapsed since last frame
-    while (!SDL_TICKS_PASSED(SDL_GetTicks(), mTicksCount + 16))
-        ;
-
-    // Delta time is the difference in ticks since last frame.
-    // ( converted to seconds )
-    float deltaTime = (SDL_GetTicks() - mTicksCount) / 1000.0f;
-    
-    // Update ticks count for next frame.
-    mTicksCount = SDL_GetTicks();
+    // Sleep until the next frame is due.
+    // Delta time is the time since last frame ( in seconds )
+    float deltaTime = mPacer.WaitForNextFrame();
 
     // Clamp maximum delta time value
-    if (deltaTime > 0.05f) {
-        deltaTime = 0.05f;
+    if (deltaTime > 0.25f) {
+        deltaTime = 0.25f;
+    }
+
+    // Step the simulation at a fixed rate, so the balls bounce the same
+    // whatever the frame rate, and keep the remainder for the next frame
+    mAccumulator += deltaTime;
+    int steps = 0;
+    while (mAccumulator >= mSimStep && steps < 8) {
+        StepSimulation(mSimStep);
+        mAccumulator -= mSimStep;
+        steps++;
+    }
+
+    // Still behind: skip a couple of renders to catch up, then drop the rest
+    mSkipRender = false;
+    if (mAccumulator >= mSimStep) {
+        if (mSkippedInARow < 2) {
+            mSkipRender = true;
+            mSkippedInARow++;
+        }
+        else {
+            mAccumulator = std::fmod(mAccumulator, mSimStep);
+            mSkippedInARow = 0;
+        }
+    }
+    else {
+        mSkippedInARow = 0;
     }
 
+    mInterpolation = mAccumulator / mSimStep;
+}
+
+void Game::StepSimulation(float deltaTime) {
+    mPaddlePrevY = mPaddlePos.y;
+    mPaddleRPrevY = mPaddleRPos.y;
+    mBalls.SavePrevious();
+
     // Update paddle position
     if (mPaddleDir != 0) {
         mPaddlePos.y += mPaddleDir * 300.0f * deltaTime;
@@ -201,53 +698,15 @@ void Game::UpdateGame() {
         }
     }
 
-    // Update ball x & y position
-    mBallPos.x += mBallVel.x * deltaTime;
-    mBallPos.y += mBallVel.y * deltaTime;
-
-    if (mBallPos.y <= THICKNESS && mBallVel.y < 0.0f) {
-        mBallVel.y *= -1;
-    }
-    else if (mBallPos.y >= (768.0f - THICKNESS) && mBallVel.y > 0.0f) {
-        mBallVel.y *= -1;
-    }
-
-    if (mBallPos.x <= THICKNESS && mBallVel.x < 0.0f) {
-        mBallVel.x *= -1;
-    }
-    else if (mBallPos.x >= (1024.0f - THICKNESS) && mBallVel.x > 0.0f) {
-        mBallVel.x *= -1;
-    }
-
-    float diffL = abs(mPaddlePos.y - mBallPos.y);
-    float diffR = abs(mPaddleRPos.y - mBallPos.y);
-
-    if (
-        // The y diff is small enough.
-        diffL <= PADDLE_H / 2.0f &&
-        // Ball is at the correct x-position.
-        mBallPos.x <= 60.0f && mBallPos.x >= 55.0f &&
-        // Ball is moving to the left.
-        mBallVel.x <= 0.0f
-       ) 
-    {
-        mBallVel.x *= -1.0f;
-    }
-
-    if (
-        // The y diff is small enough.
-        diffR <= PADDLE_H / 2.0f &&
-        // Ball is at the correct x-position.
-        mBallPos.x <= 969.0f && mBallPos.x >= 964.0f &&
-        // Ball is moving to the left.
-        mBallVel.x >= 0.0f
-        )
-    {
-        mBallVel.x *= -1.0f;
-    }
+    // Move the balls and bounce them off the walls and paddles
+    mBalls.Update(deltaTime, mPaddlePos, mPaddleRPos);
 }
 
 void Game::GenerateOutput() {
+    if (mSkipRender) {
+        return;
+    }
+
     // Sets the render draw colour
     SDL_SetRenderDrawColor (
         mRenderer,
@@ -262,27 +721,38 @@ void Game::GenerateOutput() {
 
     SDL_SetRenderDrawColor(mRenderer, 255, 255, 255, 255);
     
-    // Drawing the ball and paddle as SDL_Rects
-
-    SDL_Rect ball{
-        static_cast<int>(mBallPos.x - THICKNESS / 2),
-        static_cast<int>(mBallPos.y - THICKNESS / 2),
-        THICKNESS,
-        THICKNESS
-    };
-    SDL_RenderFillRect(mRenderer, &ball);
+    // Drawing the balls and paddles as SDL_Rects
+    // (Between the last two steps, so motion stays smooth when the frame
+    // rate and the simulation rate differ)
+    float alpha = mInterpolation;
+
+    int numBalls = mBalls.Size();
+    mBallRects.resize(numBalls);
+    for (int i = 0; i < numBalls; i++) {
+        float x = mBalls.mPrevX[i] + (mBalls.mPosX[i] - mBalls.mPrevX[i]) * alpha;
+        float y = mBalls.mPrevY[i] + (mBalls.mPosY[i] - mBalls.mPrevY[i]) * alpha;
+        mBallRects[i] = SDL_Rect{
+            static_cast<int>(x - THICKNESS / 2),
+            static_cast<int>(y - THICKNESS / 2),
+            THICKNESS,
+            THICKNESS
+        };
+    }
+    SDL_RenderFillRects(mRenderer, mBallRects.data(), numBalls);
     
+    float paddleY = mPaddlePrevY + (mPaddlePos.y - mPaddlePrevY) * alpha;
     SDL_Rect paddle {
         static_cast<int>(mPaddlePos.x - THICKNESS / 2),
-        static_cast<int>(mPaddlePos.y - PADDLE_H / 2),
+        static_cast<int>(paddleY - PADDLE_H / 2),
         THICKNESS,
         PADDLE_H
     };
     SDL_RenderFillRect(mRenderer, &paddle);
 
+    float paddleRY = mPaddleRPrevY + (mPaddleRPos.y - mPaddleRPrevY) * alpha;
     SDL_Rect paddleR{
         static_cast<int>(mPaddleRPos.x - THICKNESS / 2),
-        static_cast<int>(mPaddleRPos.y - PADDLE_H / 2),
+        static_cast<int>(paddleRY - PADDLE_H / 2),
         THICKNESS,
         PADDLE_H
     };
@@ -295,7 +765,30 @@ void Game::GenerateOutput() {
 
 int main(int argc, char* argv[])
 {
+    // --bench [balls] times the ball update headless instead of playing
+    // --balls <count> plays with that many balls
+    // --sim-rate <hz> steps the simulation that many times a second (default 60)
+    int numBalls = 1;
+    float simRate = 0.0f;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bench") == 0) {
+            int count = i + 1 < argc ? atoi(argv[i + 1]) : 0;
+            BenchmarkBalls(count > 0 ? count : 10000, 1000);
+            return 0;
+        }
+        else if (strcmp(argv[i], "--balls") == 0 && i + 1 < argc) {
+            numBalls = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--sim-rate") == 0 && i + 1 < argc) {
+            simRate = static_cast<float>(atof(argv[++i]));
+        }
+    }
+
     Game game;
+    game.SetNumBalls(numBalls);
+    if (simRate > 0.0f) {
+        game.SetSimRate(simRate);
+    }
     bool success = game.Initialise();
 
     if (success) {
@@ -1,14 +1,30 @@
 #include "Actor.h"
 #include "Game.h"
 #include "Component.h"
+#include "Profiler.h"
 #include <algorithm>
+#include <iterator>
 
 
 Actor::Actor(Game* game)
 	: mState(EActive)
+	, mUpdateAccess(EAccessShared)
+	, mSlot(-1)
+	, mSlotPending(false)
+	, mGridProxy(-1)
 	, mPosition(Vector2{ 0, 0 })
 	, mScale(1.0f)
 	, mRotation(0.0f)
+	, mPrevPosition(Vector2{ 0, 0 })
+	, mPrevRotation(0.0f)
+	, mHasPrevTransform(false)
+	, mTransformDirty(true)
+	, mTransformVersion(0)
+	, mDrawPosition(Vector2{ 0, 0 })
+	, mDrawRotation(0.0f)
+	, mDrawCos(1.0f)
+	, mDrawSin(0.0f)
+	, mWorldTransform(Matrix3::Identity)
 	, mGame(game)
 {
 	mGame->AddActor(this);
@@ -24,6 +40,16 @@ Actor::~Actor() {
 }
 
 void Actor::Update(float deltaTime) {
+	PROFILE_SCOPE("Actor::Update");
+	// Where this step starts from, for drawing in between steps
+	// (If that moves, so does the interpolated transform)
+	if (mPrevPosition != mPosition || mPrevRotation != mRotation || !mHasPrevTransform) {
+		mTransformDirty = true;
+	}
+	mPrevPosition = mPosition;
+	mPrevRotation = mRotation;
+	mHasPrevTransform = true;
+
 	if (mState == EActive) {
 		UpdateComponents(deltaTime);
 		UpdateActor(deltaTime);
@@ -32,6 +58,8 @@ void Actor::Update(float deltaTime) {
 
 void Actor::UpdateComponents(float deltaTime) {
 	for (auto comp : mComponents) {
+		// Timed here so every override is covered
+		PROFILE_SCOPE("Component::Update");
 		comp->Update(deltaTime);
 	}
 }
@@ -39,6 +67,38 @@ void Actor::UpdateComponents(float deltaTime) {
 void Actor::UpdateActor(float deltaTime) {
 }
 
+bool Actor::ComputeWorldTransform() {
+	if (!mTransformDirty) {
+		return false;
+	}
+
+	if (mHasPrevTransform) {
+		float alpha = mGame->GetInterpolation();
+		mDrawPosition = Vector2::Lerp(mPrevPosition, mPosition, alpha);
+		mDrawRotation = mPrevRotation + (mRotation - mPrevRotation) * alpha;
+	}
+	else {
+		mDrawPosition = mPosition;
+		mDrawRotation = mRotation;
+	}
+
+	mDrawCos = Math::Cos(mDrawRotation);
+	mDrawSin = Math::Sin(mDrawRotation);
+
+	// Scale * rotation * translation, without building the three matrices
+	mWorldTransform = Matrix3{ {
+		{ mDrawCos * mScale, mDrawSin * mScale, 0.0f },
+		{ -mDrawSin * mScale, mDrawCos * mScale, 0.0f },
+		{ mDrawPosition.x, mDrawPosition.y, 1.0f }
+	} };
+	mTransformVersion++;
+
+	// Still between two different steps, alpha moves on next frame
+	mTransformDirty = mHasPrevTransform
+		&& (mPrevPosition != mPosition || mPrevRotation != mRotation);
+	return true;
+}
+
 void Actor::AddComponent(class Component* component) {
 	// Find the insertion point in the sorted vector
 	// (The frist element with an order higher than me
@@ -60,8 +120,11 @@ void Actor::AddComponent(class Component* component) {
 }
 
 void Actor::RemoveComponent(class Component* component) {
-	auto iter = std::find(mComponents.begin(), mComponents.end(), component);
-	if (iter != mComponents.end()) {
-		mComponents.erase(iter);
+	// Search from the back, ~Actor deletes components last to first
+	// so this finds them straight away
+	auto iter = std::find(mComponents.rbegin(), mComponents.rend(), component);
+	if (iter != mComponents.rend()) {
+		// Erase (rather than swap) to keep the update order
+		mComponents.erase(std::next(iter).base());
 	}
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
+#include <cstddef>
 #include <vector>
 #include "Math.h"
+#include "ObjectPool.h"
 
 class Actor 
 {
@@ -12,10 +14,26 @@ public:
 		EDead
 	};
 
+	// What an actor's update touches, decides where Game runs it
+	enum UpdateAccess {
+		// Only reads/writes itself and its own components. These run in parallel
+		// on the job threads: they may spawn actors or set themselves dead, but
+		// must not touch other actors, load textures, add entities or
+		// add/remove themselves from the spatial grid
+		EAccessSelf,
+		// Touches other actors or shared game state, runs on the main thread
+		// after the parallel batch
+		EAccessShared
+	};
+
 	// Constructor/destructor
 	Actor(class Game* game);
 	virtual ~Actor();
 
+	// Actors come out of their own pool (subclasses declare their own
+	// OBJECT_POOL, or share the size class pools)
+	OBJECT_POOL(Actor)
+
 	// Update function called from update
 	void Update(float deltaTime);
 	// Updates all components attached to the actor (not overridable)
@@ -26,17 +44,39 @@ public:
 	// Getters/setters
 	// ...
 
+	// Changing the transform marks the cached world transform dirty
+	// (Setting the same value again doesn't)
 	const Vector2& GetPosition() const { return mPosition; };
-	void SetPosition(const Vector2& pos) { mPosition = pos; };
+	void SetPosition(const Vector2& pos) { mTransformDirty |= pos != mPosition; mPosition = pos; };
 
 
 	float GetScale() const { return mScale; };
-	void SetScale(float scale) { mScale = scale; };
+	void SetScale(float scale) { mTransformDirty |= scale != mScale; mScale = scale; };
 	float GetRotation() const { return mRotation; };
-	void SetRotation(float rotation) { mRotation = rotation; };
+	void SetRotation(float rotation) { mTransformDirty |= rotation != mRotation; mRotation = rotation; };
+
+	// Transform to draw with, between the previous simulation step and this one
+	// by the game's interpolation factor
+	// (Cached, as of the last Game::FlushTransforms at the start of drawing)
+	const Vector2& GetDrawPosition() const { return mDrawPosition; };
+	float GetDrawRotation() const { return mDrawRotation; };
+	float GetDrawCos() const { return mDrawCos; };
+	float GetDrawSin() const { return mDrawSin; };
+	// Scale, then rotation, then translation to the draw position
+	const Matrix3& GetWorldTransform() const { return mWorldTransform; };
+	// Goes up every time the cached transform is recomputed, so anything
+	// derived from it (sprite rects) knows when to follow
+	unsigned GetTransformVersion() const { return mTransformVersion; };
+
+	// Recompute the cached transform if anything changed since the last time
+	// (true if it was recomputed)
+	bool ComputeWorldTransform();
 
 	State GetState() const { return mState; };
 	void SetState(State state) { mState = state; };
+
+	UpdateAccess GetUpdateAccess() const { return mUpdateAccess; };
+	void SetUpdateAccess(UpdateAccess access) { mUpdateAccess = access; };
 	
 	class Game* GetGame() { return mGame; };
 	
@@ -45,14 +85,43 @@ public:
 	void AddComponent(class Component* componenent);
 	void RemoveComponent(class Component* component);
 private:
+	// Game keeps track of where the actor lives in its arrays
+	friend class Game;
+	friend class SpatialGrid;
+
 	// Actors state
 	State mState;
+	// Shared until the actor says otherwise
+	UpdateAccess mUpdateAccess;
+
+	// Index in the game's actor (or pending actor) array, -1 when not in one
+	int mSlot;
+	bool mSlotPending;
+	// Proxy in the game's spatial grid, -1 when not tracked
+	int mGridProxy;
 
 	// Transform
 	Vector2 mPosition; // Center position for actor
 	float mScale;	   // Uniforms scale for actor (1.0f for 100%)
 	float mRotation;   // Rotation angle (in radians)
 
+	// Transform at the start of the last simulation step (for interpolation)
+	Vector2 mPrevPosition;
+	float mPrevRotation;
+	// Hasn't been through a step yet, so there's nothing to interpolate from
+	bool mHasPrevTransform;
+
+	// Cached draw transform
+	// Set by the setters, and left set while interpolating between two
+	// different transforms (the result then changes every frame)
+	bool mTransformDirty;
+	unsigned mTransformVersion;
+	Vector2 mDrawPosition;
+	float mDrawRotation;
+	float mDrawCos;
+	float mDrawSin;
+	Matrix3 mWorldTransform;
+
 	std::vector<class Component*> mComponents;
 	class Game* mGame;
 };
\ No newline at end of file
@@ -1,9 +1,16 @@
 #include "AnimSpriteComponent.h"
+#include "AnimationRegistry.h"
+#include "Actor.h"
+#include "Game.h"
 #include "Math.h"
 
 AnimSpriteComponent::AnimSpriteComponent(Actor* owner, int drawOrder)
 	: SpriteComponent(owner, drawOrder)
+	, mAnimations(owner->GetGame()->GetAnimations())
+	, mCurrAnimation(AnimationRegistry::InvalidClip)
+	, mCurrClip(nullptr)
 	, mCurrFrame(0.0f)
+	, mShownFrame(-1)
 	, mAnimFPS(24.0f)
 
 {}
@@ -11,30 +18,64 @@ AnimSpriteComponent::AnimSpriteComponent(Actor* owner, int drawOrder)
 void AnimSpriteComponent::Update(float deltaTime) {
 	SpriteComponent::Update(deltaTime);
 
-	if (mCurrAnimation->size() > 0) {
+	if (mCurrClip) {
+		const std::vector<TextureHandle>& frames = mCurrClip->mFrames;
+
 		// Update the current frame based on the frame rate
 		// and delta time
 		mCurrFrame += mAnimFPS * deltaTime;
 
 		// Wrap current frame if needed
-		while (mCurrFrame >= mCurrAnimation->size()) {
-			mCurrFrame -= mCurrAnimation->size();
+		while (mCurrFrame >= frames.size()) {
+			mCurrFrame -= frames.size();
 		}
 
-		// Set the texture to current frame (casted to int)
-		SetTexture((*mCurrAnimation)[static_cast<int>(mCurrFrame)]);
+		// Only swap frames when the frame actually changes
+		// (Atlas frames share a page, so this just moves the source rect)
+		int frame = static_cast<int>(mCurrFrame);
+		if (frame != mShownFrame) {
+			ChangeTexture(frames[frame]);
+			mShownFrame = frame;
+		}
 	}
 }
 
-void AnimSpriteComponent::SetAnimTextures(const std::vector<SDL_Texture*>& textures, const char* animName) {
-	mAnimTextures[animName] = textures;
+int AnimSpriteComponent::SetAnimTextures(const std::vector<TextureHandle>& textures, const char* animName) {
+	int id = mAnimations->Register(animName, textures);
 
-	if (mAnimTextures.size() == 1) {
+	if (mCurrAnimation == AnimationRegistry::InvalidClip && id != AnimationRegistry::InvalidClip) {
 		// Set the active texture to the first frame, if this is the first animation
-		mCurrFrame = 0.0f;
-		SetTexture(mAnimTextures[animName][0]);
-		SetCurrAnimation(animName);
+		SetCurrAnimation(id);
+		mShownFrame = 0;
+		SetTexture(mCurrClip->mFrames[0]);
+	}
+	return id;
+}
+
+void AnimSpriteComponent::SetCurrAnimation(int animId) {
+	if (animId == mCurrAnimation) {
+		return;
+	}
+
+	const AnimationClip* clip = mAnimations->GetClip(animId);
+	if (!clip) {
+		SDL_Log("No animation with id %d", animId);
+		return;
+	}
+
+	mCurrAnimation = animId;
+	mCurrClip = clip;
+	mCurrFrame = 0.0f;
+	mShownFrame = -1;
+}
+
+void AnimSpriteComponent::SetCurrAnimation(const std::string& animName) {
+	int id = mAnimations->Find(animName);
+	if (id == AnimationRegistry::InvalidClip) {
+		SDL_Log("No animation named %s", animName.c_str());
+		return;
 	}
+	SetCurrAnimation(id);
 }
 
 /*
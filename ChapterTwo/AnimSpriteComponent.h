@@ -1,29 +1,36 @@
 #pragma once
 #include "SpriteComponent.h"
-#include <map>
 #include <string>
 #include <vector>
 
 class AnimSpriteComponent : public SpriteComponent 
 {
 public:
+	OBJECT_POOL(AnimSpriteComponent)
 	AnimSpriteComponent(class Actor* owner, int drawOrder = 100);
 	// Update animation (overriden from component)
 	void Update(float deltaTime) override;
-	// Set the textures used for an animation
-	void SetAnimTextures(const std::vector<SDL_Texture*>& textures, const char* animName);
+	// Register the textures for an animation with the game's AnimationRegistry
+	// (plays it if nothing is playing yet) and return its id
+	int SetAnimTextures(const std::vector<TextureHandle>& textures, const char* animName);
 	// Set/Get the animation FPS
 	float GetAnimFPS() const { return mAnimFPS; };
 	void SetAnimFPS(float fps) { mAnimFPS = fps; };
-	// Set the current animation
-	void SetCurrAnimation(std::string animName) { mCurrAnimation = &mAnimTextures[animName]; };
+	// Set the current animation by id (no lookup or allocation)
+	void SetCurrAnimation(int animId);
+	// Set the current animation by name (unknown names are logged and ignored)
+	void SetCurrAnimation(const std::string& animName);
+	int GetCurrAnimation() const { return mCurrAnimation; };
 private:
-	// All textures in the animation
-	std::map<std::string, std::vector<SDL_Texture*>> mAnimTextures;
-	// Current animation
-	std::vector<SDL_Texture*>* mCurrAnimation;
+	// Clips shared by every animated sprite
+	class AnimationRegistry* mAnimations;
+	// Current animation id and its clip
+	int mCurrAnimation;
+	const struct AnimationClip* mCurrClip;
 	// Current frame displayed
 	float mCurrFrame;
+	// Frame currently in mTexture (-1 for none)
+	int mShownFrame;
 	// Animation framerate
 	float mAnimFPS;
 };
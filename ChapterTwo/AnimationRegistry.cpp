@@ -0,0 +1,35 @@
+#include "AnimationRegistry.h"
+
+int AnimationRegistry::Register(const std::string& name, const std::vector<TextureHandle>& frames) {
+	auto iter = mIds.find(name);
+	if (iter != mIds.end()) {
+		return iter->second;
+	}
+
+	if (frames.empty()) {
+		SDL_Log("Animation has no frames: %s", name.c_str());
+		return InvalidClip;
+	}
+
+	int id = static_cast<int>(mClips.size());
+	mClips.emplace_back(AnimationClip{ name, frames });
+	mIds.emplace(name, id);
+	return id;
+}
+
+int AnimationRegistry::Find(const std::string& name) const {
+	auto iter = mIds.find(name);
+	return iter != mIds.end() ? iter->second : InvalidClip;
+}
+
+const AnimationClip* AnimationRegistry::GetClip(int id) const {
+	if (id < 0 || id >= static_cast<int>(mClips.size())) {
+		return nullptr;
+	}
+	return &mClips[id];
+}
+
+void AnimationRegistry::Clear() {
+	mIds.clear();
+	mClips.clear();
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "TextureCache.h"
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Frames of one animation, shared by every component that plays it
+// (never changes once registered)
+struct AnimationClip
+{
+	std::string mName;
+	std::vector<TextureHandle> mFrames;
+};
+
+// Every animation clip in the game, looked up by name once and by id after that.
+// Names are interned to small integer ids, so components hold an id (or the
+// clip itself) instead of their own copy of the frames and switching animation
+// never allocates. Clips live until Clear, and references to them stay valid.
+// Register/Clear are main thread only, lookups can happen from any thread.
+class AnimationRegistry
+{
+public:
+	static const int InvalidClip = -1;
+
+	// Register frames under a name and get its id
+	// (A name that's already registered keeps its first frames and id)
+	int Register(const std::string& name, const std::vector<TextureHandle>& frames);
+	// Id for a name, InvalidClip if nothing was registered under it
+	int Find(const std::string& name) const;
+
+	// Clip for a valid id, or nullptr
+	const AnimationClip* GetClip(int id) const;
+	int GetNumClips() const { return static_cast<int>(mClips.size()); };
+
+	// Drop every clip (and the texture references they hold)
+	void Clear();
+
+private:
+	// Deque so clips don't move as more are registered
+	std::deque<AnimationClip> mClips;
+	std::unordered_map<std::string, int> mIds;
+};
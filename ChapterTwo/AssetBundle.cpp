@@ -0,0 +1,198 @@
+#include "AssetBundle.h"
+#include "SDL_image.h"
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+	const char BundleMagic[4] = { 'G', 'P', 'B', 'N' };
+	// Pixel data alignment (keeps rows friendly to SIMD copies in the driver)
+	const uint64_t DataAlignment = 64;
+}
+
+AssetBundle::AssetBundle()
+{}
+
+AssetBundle::~AssetBundle() {
+	Close();
+}
+
+bool AssetBundle::Open(const std::string& fileName) {
+	Close();
+
+	if (!mFile.Open(fileName)) {
+		return false;
+	}
+	const uint8_t* data = mFile.GetData();
+	size_t size = mFile.GetSize();
+
+	// Check the header and table of contents fit and make sense
+	const FileHeader* header = reinterpret_cast<const FileHeader*>(data);
+	if (size < sizeof(FileHeader)
+		|| memcmp(header->mMagic, BundleMagic, sizeof(BundleMagic)) != 0
+		|| header->mVersion != Version
+		|| size < sizeof(FileHeader) + header->mNumImages * sizeof(TocEntry))
+	{
+		SDL_Log("Not a valid asset bundle: %s", fileName.c_str());
+		Close();
+		return false;
+	}
+
+	const TocEntry* toc = reinterpret_cast<const TocEntry*>(data + sizeof(FileHeader));
+	mImages.reserve(header->mNumImages);
+	for (uint32_t i = 0; i < header->mNumImages; i++) {
+		const TocEntry& entry = toc[i];
+		if (entry.mOffset + entry.mSize > size
+			|| static_cast<uint64_t>(entry.mPitch) * entry.mHeight > entry.mSize)
+		{
+			SDL_Log("Corrupt entry in asset bundle %s: %.*s", fileName.c_str(), MaxNameLength, entry.mName);
+			continue;
+		}
+		mImages.emplace(std::string(entry.mName, strnlen(entry.mName, MaxNameLength)), &entry);
+	}
+
+	return true;
+}
+
+void AssetBundle::Close() {
+	mFile.Close();
+	mImages.clear();
+}
+
+bool AssetBundle::Find(const std::string& fileName, Image& out) const {
+	auto iter = mImages.find(fileName);
+	if (iter == mImages.end()) {
+		return false;
+	}
+
+	const TocEntry* entry = iter->second;
+	out.mWidth = static_cast<int>(entry->mWidth);
+	out.mHeight = static_cast<int>(entry->mHeight);
+	out.mPitch = static_cast<int>(entry->mPitch);
+	out.mPixels = mFile.GetData() + entry->mOffset;
+	out.mPremultiplied = (entry->mFlags & EPremultiplied) != 0;
+
+	return true;
+}
+
+bool AssetBundle::Build(const std::string& fileName, const std::vector<std::string>& imageFiles) {
+	std::vector<TocEntry> toc;
+	std::vector<SDL_Surface*> surfaces;
+
+	// Decode everything up front so the table of contents can go first
+	uint64_t offset = sizeof(FileHeader) + imageFiles.size() * sizeof(TocEntry);
+	for (const auto& imageFile : imageFiles) {
+		if (imageFile.size() >= MaxNameLength) {
+			SDL_Log("Name too long for asset bundle: %s", imageFile.c_str());
+			continue;
+		}
+
+		SDL_Surface* decoded = IMG_Load(imageFile.c_str());
+		if (!decoded) {
+			SDL_Log("Failed to load texture file: %s", imageFile.c_str());
+			continue;
+		}
+
+		// Byte order R, G, B, A whatever the source format was
+		SDL_Surface* surf = SDL_ConvertSurfaceFormat(decoded, SDL_PIXELFORMAT_RGBA32, 0);
+		SDL_FreeSurface(decoded);
+		if (!surf) {
+			SDL_Log("Failed to convert %s to RGBA", imageFile.c_str());
+			continue;
+		}
+
+		SDL_LockSurface(surf);
+		Premultiply(surf->pixels, surf->w, surf->h, surf->pitch);
+		SDL_UnlockSurface(surf);
+
+		TocEntry entry = {};
+		memcpy(entry.mName, imageFile.c_str(), imageFile.size());
+		entry.mWidth = static_cast<uint32_t>(surf->w);
+		entry.mHeight = static_cast<uint32_t>(surf->h);
+		entry.mPitch = static_cast<uint32_t>(surf->w * 4);
+		entry.mFlags = EPremultiplied;
+		offset = (offset + DataAlignment - 1) & ~(DataAlignment - 1);
+		entry.mOffset = offset;
+		entry.mSize = static_cast<uint64_t>(entry.mPitch) * entry.mHeight;
+		offset += entry.mSize;
+
+		toc.emplace_back(entry);
+		surfaces.emplace_back(surf);
+	}
+
+	FILE* file = fopen(fileName.c_str(), "wb");
+	if (!file) {
+		SDL_Log("Failed to open asset bundle for writing: %s", fileName.c_str());
+		for (auto surf : surfaces) {
+			SDL_FreeSurface(surf);
+		}
+		return false;
+	}
+
+	FileHeader header = {};
+	memcpy(header.mMagic, BundleMagic, sizeof(BundleMagic));
+	header.mVersion = Version;
+	header.mNumImages = static_cast<uint32_t>(toc.size());
+	fwrite(&header, sizeof(header), 1, file);
+	fwrite(toc.data(), sizeof(TocEntry), toc.size(), file);
+
+	// Images that failed to load leave room in the table, pad up to the first image
+	uint64_t written = sizeof(FileHeader) + toc.size() * sizeof(TocEntry);
+	static const char zeros[DataAlignment] = {};
+	for (size_t i = 0; i < toc.size(); i++) {
+		while (written < toc[i].mOffset) {
+			size_t pad = static_cast<size_t>(toc[i].mOffset - written);
+			pad = pad < sizeof(zeros) ? pad : sizeof(zeros);
+			fwrite(zeros, 1, pad, file);
+			written += pad;
+		}
+
+		// Rows are packed tightly in the bundle
+		SDL_Surface* surf = surfaces[i];
+		for (int y = 0; y < surf->h; y++) {
+			fwrite(static_cast<const uint8_t*>(surf->pixels) + y * surf->pitch, 1, toc[i].mPitch, file);
+		}
+		written += toc[i].mSize;
+		SDL_FreeSurface(surf);
+	}
+
+	bool ok = ferror(file) == 0;
+	fclose(file);
+
+	SDL_Log("Asset bundle %s: %zu images, %llu bytes",
+		fileName.c_str(),
+		toc.size(),
+		static_cast<unsigned long long>(written)
+	);
+
+	return ok;
+}
+
+void AssetBundle::Premultiply(void* pixels, int width, int height, int pitch) {
+	for (int y = 0; y < height; y++) {
+		uint8_t* p = static_cast<uint8_t*>(pixels) + y * pitch;
+		for (int x = 0; x < width; x++, p += 4) {
+			unsigned a = p[3];
+			// (c * a + 127) / 255, rounded
+			p[0] = static_cast<uint8_t>((p[0] * a + 127) / 255);
+			p[1] = static_cast<uint8_t>((p[1] * a + 127) / 255);
+			p[2] = static_cast<uint8_t>((p[2] * a + 127) / 255);
+		}
+	}
+}
+
+void AssetBundle::Unpremultiply(void* pixels, int width, int height, int pitch) {
+	for (int y = 0; y < height; y++) {
+		uint8_t* p = static_cast<uint8_t*>(pixels) + y * pitch;
+		for (int x = 0; x < width; x++, p += 4) {
+			unsigned a = p[3];
+			if (a == 0 || a == 255) {
+				continue;
+			}
+			for (int c = 0; c < 3; c++) {
+				unsigned value = (p[c] * 255 + a / 2) / a;
+				p[c] = static_cast<uint8_t>(value > 255 ? 255 : value);
+			}
+		}
+	}
+}
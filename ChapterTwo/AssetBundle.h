@@ -0,0 +1,78 @@
+#pragma once
+#include "SDL.h"
+#include "MappedFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Single file holding every texture already decoded to premultiplied RGBA.
+// The file is memory mapped and textures are uploaded straight from the
+// mapped pixels, so loading skips the PNG decode and the per-file opens.
+//
+// Layout (little endian):
+//   FileHeader
+//   TocEntry[mNumImages]
+//   pixel data for each image (64 byte aligned, rows of mPitch bytes)
+class AssetBundle
+{
+public:
+	AssetBundle();
+	~AssetBundle();
+
+	// Map a bundle file (false if it's missing or not a bundle)
+	bool Open(const std::string& fileName);
+	void Close();
+	bool IsOpen() const { return mFile.IsOpen(); };
+	int GetNumImages() const { return static_cast<int>(mImages.size()); };
+
+	// View of an image's pixels inside the mapping (SDL_PIXELFORMAT_RGBA32)
+	struct Image {
+		int mWidth;
+		int mHeight;
+		int mPitch;
+		const void* mPixels;
+		bool mPremultiplied;
+	};
+
+	// Look up an image by the file name it was packed from
+	bool Find(const std::string& fileName, Image& out) const;
+
+	// Decode the images and write them out as a bundle (the bundler)
+	static bool Build(const std::string& fileName, const std::vector<std::string>& imageFiles);
+
+	// Convert between straight and premultiplied alpha in place (RGBA32 pixels)
+	static void Premultiply(void* pixels, int width, int height, int pitch);
+	static void Unpremultiply(void* pixels, int width, int height, int pitch);
+
+private:
+	static const uint32_t Version = 1;
+	static const int MaxNameLength = 120;
+
+	struct FileHeader {
+		char mMagic[4];
+		uint32_t mVersion;
+		uint32_t mNumImages;
+		uint32_t mReserved;
+	};
+
+	enum ImageFlags {
+		EPremultiplied = 1
+	};
+
+	struct TocEntry {
+		char mName[MaxNameLength];
+		uint32_t mWidth;
+		uint32_t mHeight;
+		uint32_t mPitch;
+		uint32_t mFlags;
+		uint64_t mOffset;
+		uint64_t mSize;
+	};
+
+	// The whole file, mapped read only
+	MappedFile mFile;
+
+	std::unordered_map<std::string, const TocEntry*> mImages;
+};
@@ -0,0 +1,125 @@
+#include "AssetLoader.h"
+#include "SDL_image.h"
+#include "Math.h"
+
+AssetLoader::AssetLoader()
+	: mInFlight(0)
+	, mQuit(false)
+{}
+
+AssetLoader::~AssetLoader() {
+	Shutdown();
+}
+
+void AssetLoader::Start(int numThreads) {
+	if (!mThreads.empty()) {
+		return;
+	}
+
+	if (numThreads <= 0) {
+		// Leave a core for the main thread, decoding is mostly I/O + zlib
+		numThreads = Math::Clamp(SDL_GetCPUCount() - 1, 1, 4);
+	}
+
+	mQuit = false;
+	for (int i = 0; i < numThreads; i++) {
+		mThreads.emplace_back(&AssetLoader::WorkerLoop, this);
+	}
+}
+
+void AssetLoader::Shutdown() {
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mQuit = true;
+	}
+	mWorkReady.notify_all();
+
+	for (auto& thread : mThreads) {
+		thread.join();
+	}
+	mThreads.clear();
+
+	// Anything nobody collected
+	for (auto& image : mFinished) {
+		SDL_FreeSurface(image.mSurface);
+	}
+	mFinished.clear();
+	mQueue.clear();
+	mInFlight = 0;
+}
+
+void AssetLoader::QueueImage(const std::string& fileName) {
+	if (mThreads.empty()) {
+		DecodedImage image = Decode(fileName);
+		std::lock_guard<std::mutex> lock(mMutex);
+		mFinished.emplace_back(image);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mQueue.emplace_back(fileName);
+		mInFlight++;
+	}
+	mWorkReady.notify_one();
+}
+
+void AssetLoader::CollectFinished(std::vector<DecodedImage>& out) {
+	std::lock_guard<std::mutex> lock(mMutex);
+	for (auto& image : mFinished) {
+		out.emplace_back(image);
+	}
+	mFinished.clear();
+}
+
+void AssetLoader::WaitForAll() {
+	std::unique_lock<std::mutex> lock(mMutex);
+	mWorkDone.wait(lock, [this] { return mInFlight == 0; });
+}
+
+int AssetLoader::GetOutstanding() {
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mInFlight + static_cast<int>(mFinished.size());
+}
+
+void AssetLoader::WorkerLoop() {
+	while (true) {
+		std::string fileName;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWorkReady.wait(lock, [this] { return mQuit || !mQueue.empty(); });
+
+			if (mQuit) {
+				return;
+			}
+
+			fileName = std::move(mQueue.front());
+			mQueue.pop_front();
+		}
+
+		DecodedImage image = Decode(fileName);
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mFinished.emplace_back(image);
+			mInFlight--;
+		}
+		mWorkDone.notify_all();
+	}
+}
+
+AssetLoader::DecodedImage AssetLoader::Decode(const std::string& fileName) {
+	DecodedImage image;
+	image.mFileName = fileName;
+
+	Uint64 start = SDL_GetPerformanceCounter();
+	image.mSurface = IMG_Load(fileName.c_str());
+	image.mDecodeTime = static_cast<double>(SDL_GetPerformanceCounter() - start)
+		/ SDL_GetPerformanceFrequency();
+
+	if (!image.mSurface) {
+		SDL_Log("Failed to load texture file: %s", fileName.c_str());
+	}
+
+	return image;
+}
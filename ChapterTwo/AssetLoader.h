@@ -0,0 +1,59 @@
+#pragma once
+#include "SDL.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Decodes images (IMG_Load to SDL_Surface) on a pool of worker threads.
+// Only the file read and decode happen off the main thread, the renderer
+// upload is left to whoever collects the finished surfaces.
+class AssetLoader
+{
+public:
+	AssetLoader();
+	~AssetLoader();
+
+	// Start the worker threads (0 picks a count from the number of cores)
+	void Start(int numThreads = 0);
+	// Stop and join the workers (unclaimed surfaces are freed)
+	void Shutdown();
+	int GetNumThreads() const { return static_cast<int>(mThreads.size()); };
+
+	struct DecodedImage {
+		std::string mFileName;
+		// nullptr if the decode failed
+		SDL_Surface* mSurface;
+		// Seconds spent in IMG_Load
+		double mDecodeTime;
+	};
+
+	// Queue an image to be decoded
+	// (Decodes straight away on the calling thread if no workers are running)
+	void QueueImage(const std::string& fileName);
+	// Move any finished decodes into out without blocking
+	void CollectFinished(std::vector<DecodedImage>& out);
+	// Block until every queued image has been decoded
+	void WaitForAll();
+	// Images queued or being decoded that haven't been collected yet
+	int GetOutstanding();
+
+private:
+	void WorkerLoop();
+	static DecodedImage Decode(const std::string& fileName);
+
+	std::vector<std::thread> mThreads;
+
+	std::mutex mMutex;
+	// Signalled when work is queued or on shutdown
+	std::condition_variable mWorkReady;
+	// Signalled when a decode finishes
+	std::condition_variable mWorkDone;
+	std::deque<std::string> mQueue;
+	std::vector<DecodedImage> mFinished;
+	// Queued + in progress
+	int mInFlight;
+	bool mQuit;
+};
@@ -1,5 +1,9 @@
 #include "BGSpriteComponent.h"
 #include "Actor.h"
+#include "Game.h"
+#include "SpriteBatch.h"
+#include "Profiler.h"
+#include "Camera.h"
 
 BGSpriteComponent::BGSpriteComponent(Actor* owner, int drawOrder)
 	: SpriteComponent(owner, drawOrder)
@@ -20,29 +24,39 @@ void BGSpriteComponent::Update(float deltaTime) {
 	}
 }
 
-void BGSpriteComponent::Draw(SDL_Renderer* renderer) {
+void BGSpriteComponent::Draw(SpriteBatch* batch) {
+	PROFILE_SCOPE("BGSpriteComponent::Draw");
+	Vector2 pos = mOwner->GetDrawPosition();
+	// Offsets are as of the latest step, back them up to where the
+	// scroll was at the interpolated time
+	Game* game = mOwner->GetGame();
+	Camera* camera = game->GetCamera();
+	float lag = mScrollSpeed * (1.0f - game->GetInterpolation()) * game->GetSimStep();
 	for (auto& bg : mBGTextures) {
+		// Texture may still be loading
+		if (!bg.mTexture) {
+			continue;
+		}
+
 		SDL_Rect r;
 		// Assume the screen dimensions
 		r.w = static_cast<int>(mScreenSize.x);
 		r.h = static_cast<int>(mScreenSize.y);
 		// Center the rectangle around the position of the owner
-		r.x = static_cast<int>(mOwner->GetPosition().x - r.w / 2 + bg.mOffset.x);
-		r.y = static_cast<int>(mOwner->GetPosition().y - r.h / 2 + bg.mOffset.y);
-
-		SDL_RenderCopy(
-			renderer,
-			bg.mTexture,
-			nullptr,
-			&r
-		);
+		r.x = static_cast<int>(pos.x - r.w / 2 + bg.mOffset.x - lag);
+		r.y = static_cast<int>(pos.y - r.h / 2 + bg.mOffset.y);
+
+		if (!camera->SubmitScreen(r)) {
+			continue;
+		}
+		batch->Draw(bg.mTexture, r);
 	}
 }
 
-void BGSpriteComponent::SetBGTextures(const std::vector<SDL_Texture*>& textures) {
+void BGSpriteComponent::SetBGTextures(const std::vector<TextureHandle>& textures) {
 	int count = 0;
 
-	for (auto tex : textures) {
+	for (const auto& tex : textures) {
 		BGTexture temp;
 		temp.mTexture = tex;
 		// Each texture is screen width in offset
@@ -6,13 +6,17 @@
 
 class BGSpriteComponent : public SpriteComponent {
 public:
+	OBJECT_POOL(BGSpriteComponent)
 	// Set draw order to lower (so it's in background)
 	BGSpriteComponent(class Actor* owner, int drawOrder = 10);
 	// Update/Draw overriden from parent
 	void Update(float deltaTime) override;
-	void Draw(SDL_Renderer* renderer) override;
+	// Backgrounds are drawn in screen space (the camera doesn't move them),
+	// panels scrolled off screen are culled one at a time
+	void Draw(class SpriteBatch* batch) override;
+	bool Cull(class Camera*) override { return false; };
 	// Set the textures used for the background
-	void SetBGTextures(const std::vector<SDL_Texture*>& textures);
+	void SetBGTextures(const std::vector<TextureHandle>& textures);
 	// Get/Set screen size and scroll speed 
 	void SetScreenSize(const Vector2& size) { mScreenSize = size; };
 	void SetScrollSpeed(float speed) { mScrollSpeed = speed; };
@@ -21,7 +25,7 @@ public:
 private:
 	// Struct to encapsulate each BG image and its offset
 	struct BGTexture {
-		SDL_Texture* mTexture;
+		TextureHandle mTexture;
 		Vector2 mOffset;
 	};
 
@@ -0,0 +1,18 @@
+#include "Benchmark.h"
+#include "SDL.h"
+#include <cstring>
+
+// Entry point of the ChapterTwoBench executable
+// (same suite as the game's --bench, plus heap allocation counts)
+//   --json <file>   also write the results out as JSON
+// Exits with 1 if any benchmark's checks failed
+int main(int argc, char* args[]) {
+	const char* jsonFile = nullptr;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(args[i], "--json") == 0 && i + 1 < argc) {
+			jsonFile = args[++i];
+		}
+	}
+
+	return Benchmark::RunAll(jsonFile) ? 0 : 1;
+}
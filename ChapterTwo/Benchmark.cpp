@@ -0,0 +1,977 @@
+#include "Benchmark.h"
+#include "Game.h"
+#include "Actor.h"
+#include "Component.h"
+#include "SpriteComponent.h"
+#include "AnimSpriteComponent.h"
+#include "BGSpriteComponent.h"
+#include "ParallaxComponent.h"
+#include "EntityWorld.h"
+#include "TileMapComponent.h"
+#include "SpatialGrid.h"
+#include "SpriteBatch.h"
+#include "Camera.h"
+#include "ObjectPool.h"
+#include "SDL.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace
+{
+	double SecondsSince(Uint64 start) {
+		return static_cast<double>(SDL_GetPerformanceCounter() - start)
+			/ SDL_GetPerformanceFrequency();
+	}
+
+	struct Result {
+		std::string mName;
+		int mSize;
+		long long mOps;
+		double mNsPerOp;
+		double mHeapAllocsPerOp;
+		double mPoolAllocsPerOp;
+	};
+
+	std::vector<Result> sResults;
+
+	// Set by the counting allocator, which only the benchmark executable links
+	Benchmark::HeapCounter sHeapCounter = nullptr;
+
+	long long HeapAllocations() {
+		return sHeapCounter ? sHeapCounter() : 0;
+	}
+
+	// Counters at the start of a measurement
+	struct Measure {
+		Uint64 mStart;
+		long long mHeapAllocations;
+		int mPoolAllocations;
+	};
+
+	Measure StartMeasure() {
+		Measure measure;
+		measure.mHeapAllocations = HeapAllocations();
+		measure.mPoolAllocations = ObjectPool::GetTotalStats().mAllocations;
+		measure.mStart = SDL_GetPerformanceCounter();
+		return measure;
+	}
+
+	// Finish a measurement of ops operations and record it
+	void Report(const char* name, int size, long long ops, const Measure& measure) {
+		double elapsed = SecondsSince(measure.mStart);
+		long long heap = HeapAllocations() - measure.mHeapAllocations;
+		int pool = ObjectPool::GetTotalStats().mAllocations - measure.mPoolAllocations;
+		double perOp = ops > 0 ? 1.0 / ops : 0.0;
+
+		// Heap allocations are -1 when nothing is counting them
+		Result result{ name, size, ops, elapsed * 1e9 * perOp, sHeapCounter ? heap * perOp : -1.0, pool * perOp };
+		sResults.emplace_back(result);
+
+		char heapText[32];
+		if (sHeapCounter) {
+			snprintf(heapText, sizeof(heapText), "%6.2f", result.mHeapAllocsPerOp);
+		}
+		else {
+			snprintf(heapText, sizeof(heapText), "%6s", "n/a");
+		}
+		SDL_Log("[bench] %-16s %7d  %10.1f ns/op  %s heap allocs/op  %6.2f pool allocs/op",
+			name,
+			size,
+			result.mNsPerOp,
+			heapText,
+			result.mPoolAllocsPerOp
+		);
+	}
+
+	// Headless game with no frame limit and the update on one thread
+	bool StartGame(Game& game) {
+		game.SetHeadless(true);
+		game.SetFixedDeltaTime(1.0f / 60.0f);
+		game.SetNumThreads(1);
+		return game.Initialise();
+	}
+
+	// Same sequence every run so results are comparable
+	std::mt19937& Random() {
+		static std::mt19937 random(1234);
+		return random;
+	}
+
+	// Animation frames from the atlas LoadData builds
+	std::vector<TextureHandle> SkeletonFrames(Game& game) {
+		std::vector<TextureHandle> frames;
+		for (int i = 1; i <= 6; i++) {
+			char fileName[64];
+			snprintf(fileName, sizeof(fileName), "Assets/Skeleton/Character%02d.png", i);
+			frames.emplace_back(game.GetTexture(fileName));
+		}
+		return frames;
+	}
+
+	// Actor that integrates its own velocity, the way gameplay code does today
+	class MoverActor : public Actor
+	{
+	public:
+		OBJECT_POOL(MoverActor)
+
+		MoverActor(Game* game, const Vector2& velocity)
+			: Actor(game)
+			, mVelocity(velocity)
+		{}
+
+		void UpdateActor(float deltaTime) override {
+			SetPosition(GetPosition() + mVelocity * deltaTime);
+		}
+
+	private:
+		Vector2 mVelocity;
+	};
+
+	// Actor with a bit more per-frame work (steering towards a moving heading)
+	// that only touches itself, so it can run on the job threads
+	class WanderActor : public Actor
+	{
+	public:
+		OBJECT_POOL(WanderActor)
+
+		WanderActor(Game* game, float phase)
+			: Actor(game)
+			, mPhase(phase)
+		{
+			SetUpdateAccess(EAccessSelf);
+		}
+
+		void UpdateActor(float deltaTime) override {
+			mPhase += deltaTime;
+			float heading = GetRotation();
+			for (int i = 0; i < 4; i++) {
+				heading += Math::Sin(mPhase * (i + 1)) * 0.25f * deltaTime;
+			}
+			SetRotation(heading);
+
+			Vector2 pos = GetPosition();
+			pos.x += Math::Cos(heading) * 50.0f * deltaTime;
+			pos.y -= Math::Sin(heading) * 50.0f * deltaTime;
+			SetPosition(pos);
+		}
+
+	private:
+		float mPhase;
+	};
+}
+
+void Benchmark::SetHeapCounter(HeapCounter counter) {
+	sHeapCounter = counter;
+}
+
+bool Benchmark::RunAll(const char* jsonFile) {
+	const int sizes[] = { 1000, 10000, 100000 };
+	bool passed = true;
+
+	for (int size : sizes) {
+		AddSprite(size);
+		RemoveActor(size);
+		RemoveSprite(size);
+		AddComponent(size);
+		AnimUpdate(size);
+		BGUpdate(size);
+		Parallax(size);
+		HeadlessFrame(size);
+		SpriteDraw(size);
+		Culling(size);
+	}
+
+	ActorChurn();
+	EntityUpdate();
+	ParallelUpdate();
+
+	Collision(1000);
+	Collision(10000);
+	Collision(100000);
+
+	TileMap(100);
+	TileMap(2000);
+
+	passed &= MathBatch(1000);
+	passed &= MathBatch(100000);
+
+	if (jsonFile && !WriteJSON(jsonFile)) {
+		passed = false;
+	}
+
+	return passed;
+}
+
+bool Benchmark::WriteJSON(const std::string& fileName) {
+	FILE* file = fopen(fileName.c_str(), "w");
+	if (!file) {
+		SDL_Log("Failed to open benchmark output: %s", fileName.c_str());
+		return false;
+	}
+
+	fprintf(file, "{\n  \"benchmarks\": [\n");
+	for (size_t i = 0; i < sResults.size(); i++) {
+		const Result& r = sResults[i];
+		// null when heap allocations weren't counted
+		char heap[32];
+		if (r.mHeapAllocsPerOp >= 0.0) {
+			snprintf(heap, sizeof(heap), "%.4f", r.mHeapAllocsPerOp);
+		}
+		else {
+			snprintf(heap, sizeof(heap), "null");
+		}
+		fprintf(file, "    { \"name\": \"%s\", \"size\": %d, \"ops\": %lld, \"ns_per_op\": %.3f, "
+			"\"heap_allocs_per_op\": %s, \"pool_allocs_per_op\": %.4f }%s\n",
+			r.mName.c_str(),
+			r.mSize,
+			r.mOps,
+			r.mNsPerOp,
+			heap,
+			r.mPoolAllocsPerOp,
+			i + 1 < sResults.size() ? "," : ""
+		);
+	}
+	fprintf(file, "  ]\n}\n");
+	fclose(file);
+
+	return true;
+}
+
+void Benchmark::AddSprite(int count) {
+	Game game;
+	if (StartGame(game)) {
+		// One actor per sprite, draw orders all over the place
+		std::vector<Actor*> actors;
+		std::vector<int> orders;
+		for (int i = 0; i < count; i++) {
+			actors.emplace_back(new Actor(&game));
+			orders.emplace_back(static_cast<int>(Random()() % 1000));
+		}
+
+		Measure measure = StartMeasure();
+		for (int i = 0; i < count; i++) {
+			new SpriteComponent(actors[i], orders[i]);
+		}
+		Report("AddSprite", count, count, measure);
+	}
+	game.Shutdown();
+}
+
+void Benchmark::RemoveActor(int count) {
+	Game game;
+	if (StartGame(game)) {
+		std::vector<Actor*> actors;
+		for (int i = 0; i < count; i++) {
+			actors.emplace_back(new Actor(&game));
+		}
+		std::shuffle(actors.begin(), actors.end(), Random());
+
+		// ~Actor does the RemoveActor
+		Measure measure = StartMeasure();
+		for (auto actor : actors) {
+			delete actor;
+		}
+		Report("RemoveActor", count, count, measure);
+	}
+	game.Shutdown();
+}
+
+void Benchmark::RemoveSprite(int count) {
+	Game game;
+	if (StartGame(game)) {
+		// Sprites go in ascending order so setting up isn't the slow part
+		Actor* actor = new Actor(&game);
+		std::vector<SpriteComponent*> sprites;
+		for (int i = 0; i < count; i++) {
+			sprites.emplace_back(new SpriteComponent(actor, i % 1000));
+		}
+		std::shuffle(sprites.begin(), sprites.end(), Random());
+
+		// ~SpriteComponent does the RemoveSprite (and RemoveComponent)
+		Measure measure = StartMeasure();
+		for (auto sprite : sprites) {
+			delete sprite;
+		}
+		Report("RemoveSprite", count, count, measure);
+	}
+	game.Shutdown();
+}
+
+void Benchmark::AddComponent(int count, int componentsPerActor) {
+	Game game;
+	if (StartGame(game)) {
+		std::vector<Actor*> actors;
+		for (int i = 0; i < count; i++) {
+			actors.emplace_back(new Actor(&game));
+		}
+
+		std::vector<int> orders;
+		for (int i = 0; i < componentsPerActor; i++) {
+			orders.emplace_back(static_cast<int>(Random()() % 200));
+		}
+
+		Measure measure = StartMeasure();
+		for (auto actor : actors) {
+			for (int order : orders) {
+				new Component(actor, order);
+			}
+		}
+		Report("AddComponent", count, static_cast<long long>(count) * componentsPerActor, measure);
+	}
+	game.Shutdown();
+}
+
+void Benchmark::AnimUpdate(int count, int frames) {
+	Game game;
+	if (StartGame(game)) {
+		std::vector<TextureHandle> walk = SkeletonFrames(game);
+		std::vector<TextureHandle> back(walk.rbegin(), walk.rend());
+
+		std::vector<AnimSpriteComponent*> anims;
+		int walkId = 0;
+		int backId = 0;
+		for (int i = 0; i < count; i++) {
+			AnimSpriteComponent* anim = new AnimSpriteComponent(new Actor(&game));
+			// Every component shares the same two clips
+			walkId = anim->SetAnimTextures(walk, "Walk");
+			backId = anim->SetAnimTextures(back, "Walk Back");
+			// Spread them out so they don't all change frame together
+			anim->SetAnimFPS(12.0f + i % 13);
+			anims.emplace_back(anim);
+		}
+
+		Measure measure = StartMeasure();
+		for (int frame = 0; frame < frames; frame++) {
+			for (auto anim : anims) {
+				anim->Update(1.0f / 60.0f);
+			}
+		}
+		Report("AnimUpdate", count, static_cast<long long>(count) * frames, measure);
+
+		// Switch clips by id every frame (should never allocate)
+		measure = StartMeasure();
+		for (int frame = 0; frame < frames; frame++) {
+			int id = frame % 2 ? walkId : backId;
+			for (auto anim : anims) {
+				anim->SetCurrAnimation(id);
+				anim->Update(1.0f / 60.0f);
+			}
+		}
+		Report("AnimSwitch", count, static_cast<long long>(count) * frames, measure);
+	}
+	game.Shutdown();
+}
+
+void Benchmark::BGUpdate(int count, int frames) {
+	Game game;
+	if (StartGame(game)) {
+		TextureHandle stars = game.GetTexture("Assets/Stars.png");
+
+		std::vector<BGSpriteComponent*> bgs;
+		for (int i = 0; i < count; i++) {
+			BGSpriteComponent* bg = new BGSpriteComponent(new Actor(&game));
+			bg->SetScreenSize(Vector2{ static_cast<float>(Game::ScreenWidth), static_cast<float>(Game::ScreenHeight) });
+			bg->SetBGTextures({ stars, stars });
+			bg->SetScrollSpeed(-100.0f - i % 200);
+			bgs.emplace_back(bg);
+		}
+
+		Measure measure = StartMeasure();
+		for (int frame = 0; frame < frames; frame++) {
+			for (auto bg : bgs) {
+				bg->Update(1.0f / 60.0f);
+			}
+		}
+		Report("BGUpdate", count, static_cast<long long>(count) * frames, measure);
+	}
+	game.Shutdown();
+}
+
+void Benchmark::Parallax(int count, int frames) {
+	const int layersPerComponent = 8;
+	Game game;
+	game.SetHeadlessRendering(true);
+	if (StartGame(game)) {
+		TextureHandle stars = game.GetTexture("Assets/Stars.png");
+
+		std::vector<ParallaxComponent*> parallaxes;
+		for (int i = 0; i < count; i += layersPerComponent) {
+			ParallaxComponent* parallax = new ParallaxComponent(new Actor(&game));
+			for (int layer = 0; layer < layersPerComponent; layer++) {
+				parallax->AddLayer(stars, -25.0f * (layer + 1) - i % 200, layer % 2 == 1);
+			}
+			parallaxes.emplace_back(parallax);
+		}
+		// Draw once so every layer knows its width and wraps
+		game.RunFrames(1);
+
+		Measure measure = StartMeasure();
+		for (int frame = 0; frame < frames; frame++) {
+			for (auto parallax : parallaxes) {
+				parallax->Update(1.0f / 60.0f);
+			}
+		}
+		Report("ParallaxUpdate", count, static_cast<long long>(parallaxes.size()) * layersPerComponent * frames, measure);
+	}
+	game.Shutdown();
+
+	// Drawn on its own, the cost shouldn't depend on count
+	Game drawGame;
+	drawGame.SetHeadlessRendering(true);
+	if (StartGame(drawGame)) {
+		TextureHandle stars = drawGame.GetTexture("Assets/Stars.png");
+
+		Actor* actor = new Actor(&drawGame);
+		actor->SetPosition(Vector2{ Game::ScreenWidth / 2.0f, Game::ScreenHeight / 2.0f });
+		ParallaxComponent* parallax = new ParallaxComponent(actor);
+		for (int layer = 0; layer < layersPerComponent; layer++) {
+			parallax->AddLayer(stars, -25.0f * (layer + 1), layer % 2 == 1);
+		}
+
+		Measure measure = StartMeasure();
+		drawGame.RunFrames(frames);
+		Report("ParallaxDraw", count, frames, measure);
+
+		SDL_Log("  last frame: %d blits for %d layers",
+			parallax->GetBlitsDrawn(),
+			parallax->GetNumLayers()
+		);
+	}
+	drawGame.Shutdown();
+}
+
+void Benchmark::HeadlessFrame(int count, int frames) {
+	Game game;
+	if (StartGame(game)) {
+		std::vector<TextureHandle> walk = SkeletonFrames(game);
+
+		// Moving animated actors, roughly what a busy scene looks like
+		for (int i = 0; i < count; i++) {
+			MoverActor* actor = new MoverActor(&game, Vector2{ 1.0f, static_cast<float>(i % 7) });
+			AnimSpriteComponent* anim = new AnimSpriteComponent(actor, i % 1000);
+			anim->SetAnimTextures(walk, "Walk");
+		}
+
+		Measure measure = StartMeasure();
+		game.RunFrames(frames);
+		Report("HeadlessFrame", count, static_cast<long long>(count) * frames, measure);
+	}
+	game.Shutdown();
+}
+
+void Benchmark::ActorChurn(int actorsPerSecond, int population, int seconds) {
+	Game game;
+	game.SetHeadless(true);
+	game.SetFixedDeltaTime(1.0f / 60.0f);
+
+	if (!game.Initialise()) {
+		game.Shutdown();
+		return;
+	}
+
+	// Live population that just sits there
+	for (int i = 0; i < population; i++) {
+		new Actor(&game);
+	}
+
+	// Each frame spawns a wave and kills the previous one
+	const int frames = 60 * seconds;
+	const int perFrame = actorsPerSecond / 60;
+	std::vector<Actor*> wave;
+	wave.reserve(perFrame);
+
+	Measure measure = StartMeasure();
+	for (int frame = 0; frame < frames; frame++) {
+		for (auto actor : wave) {
+			actor->SetState(Actor::EDead);
+		}
+		wave.clear();
+
+		for (int i = 0; i < perFrame; i++) {
+			wave.emplace_back(new Actor(&game));
+		}
+
+		game.RunFrames(1);
+	}
+	double elapsed = SecondsSince(measure.mStart);
+
+	int churned = perFrame * frames;
+	Report("ActorChurn", population, churned, measure);
+	SDL_Log("ActorChurn: %d spawned+killed over %d frames with %d live actors",
+		churned,
+		frames,
+		population
+	);
+	SDL_Log("  %.3f ms total, %.1f ns per actor, %.3f ms per frame (%.1f%% of a 16.6 ms frame)",
+		elapsed * 1000.0,
+		elapsed * 1e9 / churned,
+		elapsed * 1000.0 / frames,
+		100.0 * (elapsed / frames) / (1.0 / 60.0)
+	);
+
+	game.Shutdown();
+}
+
+
+void Benchmark::EntityUpdate(int count, int frames) {
+	const float deltaTime = 1.0f / 60.0f;
+
+	// Actors, each one a separate heap object with a virtual update
+	double actorTime = 0.0;
+	{
+		Game game;
+		game.SetHeadless(true);
+		game.SetFixedDeltaTime(deltaTime);
+
+		if (game.Initialise()) {
+			for (int i = 0; i < count; i++) {
+				new MoverActor(&game, Vector2{ 1.0f, static_cast<float>(i % 7) });
+			}
+
+			Measure measure = StartMeasure();
+			game.RunFrames(frames);
+			actorTime = SecondsSince(measure.mStart);
+			Report("EntityActors", count, static_cast<long long>(count) * frames, measure);
+		}
+		game.Shutdown();
+	}
+
+	// The same data as dense pools
+	EntityWorld world;
+	for (int i = 0; i < count; i++) {
+		Entity e = world.CreateEntity();
+		world.AddTransform(e, Vector2{ 0.0f, 0.0f });
+		world.AddVelocity(e, Vector2{ 1.0f, static_cast<float>(i % 7) });
+	}
+
+	Measure measure = StartMeasure();
+	for (int frame = 0; frame < frames; frame++) {
+		world.Update(deltaTime);
+	}
+	double worldTime = SecondsSince(measure.mStart);
+	Report("EntityPools", count, static_cast<long long>(count) * frames, measure);
+
+	double updates = static_cast<double>(count) * frames;
+	SDL_Log("EntityUpdate: %d entities x %d frames", count, frames);
+	SDL_Log("  actors %.2f ns/entity, pools %.2f ns/entity (%.1fx)",
+		actorTime * 1e9 / updates,
+		worldTime * 1e9 / updates,
+		worldTime > 0.0 ? actorTime / worldTime : 0.0
+	);
+}
+
+void Benchmark::ParallelUpdate(int count, int frames) {
+	const int threadCounts[] = { 1, 2, 4, 8 };
+	double baseTime = 0.0;
+
+	SDL_Log("ParallelUpdate: %d actors x %d frames", count, frames);
+
+	for (int numThreads : threadCounts) {
+		Game game;
+		game.SetHeadless(true);
+		game.SetFixedDeltaTime(1.0f / 60.0f);
+		game.SetNumThreads(numThreads);
+
+		if (!game.Initialise()) {
+			game.Shutdown();
+			return;
+		}
+
+		for (int i = 0; i < count; i++) {
+			new WanderActor(&game, static_cast<float>(i % 97));
+		}
+
+		char name[32];
+		snprintf(name, sizeof(name), "ParallelUpdate%dT", numThreads);
+
+		Measure measure = StartMeasure();
+		game.RunFrames(frames);
+		double elapsed = SecondsSince(measure.mStart);
+		Report(name, count, static_cast<long long>(count) * frames, measure);
+
+		if (numThreads == 1) {
+			baseTime = elapsed;
+		}
+
+		JobSystem::Stats stats = game.GetJobs()->GetStats();
+		SDL_Log("  %d threads: %.3f ms per frame, %.1fx, %d jobs (%d stolen)",
+			numThreads,
+			elapsed * 1000.0 / frames,
+			elapsed > 0.0 ? baseTime / elapsed : 0.0,
+			stats.mJobsRun,
+			stats.mJobsStolen
+		);
+
+		game.Shutdown();
+	}
+}
+
+void Benchmark::Collision(int count, int frames) {
+	Game game;
+	if (StartGame(game)) {
+		SpatialGrid* grid = game.GetGrid();
+
+		// 16x16 actors, on average one every 48x48 pixels
+		float side = std::sqrt(static_cast<float>(count)) * 48.0f;
+		std::uniform_real_distribution<float> position(0.0f, side);
+		std::uniform_real_distribution<float> speed(-120.0f, 120.0f);
+
+		std::vector<MoverActor*> actors;
+		for (int i = 0; i < count; i++) {
+			MoverActor* actor = new MoverActor(&game, Vector2{ speed(Random()), speed(Random()) });
+			actor->SetPosition(Vector2{ position(Random()), position(Random()) });
+			actors.emplace_back(actor);
+		}
+
+		Measure measure = StartMeasure();
+		for (auto actor : actors) {
+			grid->Add(actor, Vector2{ 8.0f, 8.0f });
+		}
+		Report("GridAdd", count, count, measure);
+
+		// Move everything a frame's worth, then catch the grid up
+		long long ops = static_cast<long long>(count) * frames;
+		measure = StartMeasure();
+		for (int frame = 0; frame < frames; frame++) {
+			for (auto actor : actors) {
+				actor->UpdateActor(1.0f / 60.0f);
+			}
+			grid->UpdateAll();
+		}
+		Report("GridUpdate", count, ops, measure);
+
+		std::vector<std::pair<Actor*, Actor*>> pairs;
+		measure = StartMeasure();
+		for (int frame = 0; frame < frames; frame++) {
+			pairs.clear();
+			grid->QueryPairs(pairs);
+		}
+		Report("GridPairs", count, ops, measure);
+		size_t gridPairs = pairs.size();
+
+		// Everything within 64 pixels of each actor
+		std::vector<Actor*> nearby;
+		size_t found = 0;
+		measure = StartMeasure();
+		for (auto actor : actors) {
+			nearby.clear();
+			grid->QueryRadius(actor->GetPosition(), 64.0f, nearby);
+			found += nearby.size();
+		}
+		Report("GridRadius", count, count, measure);
+
+		// Every box against every other one
+		size_t brutePairs = 0;
+		measure = StartMeasure();
+		for (int a = 0; a < count; a++) {
+			Vector2 posA = actors[a]->GetPosition();
+			for (int b = a + 1; b < count; b++) {
+				Vector2 posB = actors[b]->GetPosition();
+				if (Math::Abs(posA.x - posB.x) <= 16.0f && Math::Abs(posA.y - posB.y) <= 16.0f) {
+					brutePairs++;
+				}
+			}
+		}
+		Report("BrutePairs", count, count, measure);
+
+		SDL_Log("  %zu overlapping pairs (all-pairs found %zu), %.1f actors within 64 px on average",
+			gridPairs,
+			brutePairs,
+			static_cast<double>(found) / count
+		);
+	}
+	game.Shutdown();
+}
+
+void Benchmark::TileMap(int size, int frames) {
+	Game game;
+	if (StartGame(game)) {
+		const char* csvFile = "bench_tilemap.csv";
+		const char* mapFile = "bench_tilemap.map";
+
+		// Stars.png cut into 32x32 tiles gives 768 of them
+		TextureHandle tileSet = game.GetTexture("Assets/Stars.png");
+		const int numTiles = (tileSet.GetWidth() / 32) * (tileSet.GetHeight() / 32);
+
+		FILE* file = fopen(csvFile, "w");
+		if (!file || numTiles <= 0) {
+			SDL_Log("TileMap: couldn't set up the benchmark");
+			if (file) {
+				fclose(file);
+			}
+			game.Shutdown();
+			return;
+		}
+		for (int y = 0; y < size; y++) {
+			for (int x = 0; x < size; x++) {
+				// A few empty cells like a real map
+				int tile = (x * 7 + y * 13) % (numTiles + 8);
+				fprintf(file, x + 1 < size ? "%d," : "%d\n", tile < numTiles ? tile : -1);
+			}
+		}
+		fclose(file);
+
+		Actor* owner = new Actor(&game);
+		TileMapComponent* tileMap = new TileMapComponent(owner);
+		tileMap->SetTileSet(tileSet, 32, 32);
+		long long cells = static_cast<long long>(size) * size;
+
+		// One op per tile
+		Measure measure = StartMeasure();
+		tileMap->LoadMap(csvFile);
+		Report("TileMapCSV", size, cells, measure);
+
+		TileMapComponent::ConvertMap(csvFile, mapFile);
+
+		// One op per load, mapping doesn't touch the tiles
+		measure = StartMeasure();
+		tileMap->LoadMap(mapFile);
+		Report("TileMapMapped", size, 1, measure);
+
+		// Scroll diagonally across the map with the batch drawing nowhere
+		SpriteBatch batch;
+		long long tilesDrawn = 0;
+		measure = StartMeasure();
+		for (int frame = 0; frame < frames; frame++) {
+			owner->SetPosition(Vector2{ -10.0f * frame, -5.0f * frame });
+			batch.Begin();
+			tileMap->Draw(&batch);
+			batch.End();
+			tilesDrawn += tileMap->GetTilesDrawn();
+		}
+		Report("TileMapDraw", size, frames, measure);
+		SDL_Log("  %.1f tiles drawn per frame", static_cast<double>(tilesDrawn) / frames);
+		remove(csvFile);
+
+		// Whole rendered frames scrolling over the map, per tile vs cached chunks
+		const bool chunkModes[] = { false, true };
+		for (bool chunks : chunkModes) {
+			Game renderGame;
+			renderGame.SetHeadlessRendering(true);
+			if (StartGame(renderGame)) {
+				MoverActor* scroller = new MoverActor(&renderGame, Vector2{ -600.0f, -300.0f });
+				TileMapComponent* layer = new TileMapComponent(scroller);
+				layer->SetTileSet(renderGame.GetTexture("Assets/Stars.png"), 32, 32);
+				layer->LoadMap(mapFile);
+				layer->SetChunkCaching(chunks);
+
+				measure = StartMeasure();
+				renderGame.RunFrames(frames);
+				Report(chunks ? "TileMapChunks" : "TileMapTiles", size, frames, measure);
+				SDL_Log("  last frame: %d tiles, %d chunks drawn (%d baked), %zu bytes of chunks",
+					layer->GetTilesDrawn(),
+					layer->GetChunksDrawn(),
+					layer->GetChunksBaked(),
+					layer->GetChunkBytes()
+				);
+			}
+			renderGame.Shutdown();
+		}
+
+		remove(mapFile);
+	}
+	game.Shutdown();
+}
+
+bool Benchmark::MathBatch(int count, int frames) {
+	std::uniform_real_distribution<float> coord(-1000.0f, 1000.0f);
+	std::uniform_real_distribution<float> extent(1.0f, 64.0f);
+	std::uniform_real_distribution<float> angle(-1000.0f, 1000.0f);
+
+	std::vector<Vector2> points(count);
+	std::vector<Vector2> velocities(count);
+	std::vector<Vector2> halfExtents(count);
+	std::vector<float> angles(count);
+	for (int i = 0; i < count; i++) {
+		points[i] = Vector2{ coord(Random()), coord(Random()) };
+		velocities[i] = Vector2{ coord(Random()), coord(Random()) };
+		halfExtents[i] = Vector2{ extent(Random()), extent(Random()) };
+		angles[i] = angle(Random());
+	}
+
+	Matrix3 mat = Matrix3::CreateScale(1.5f)
+		* Matrix3::CreateRotation(0.3f)
+		* Matrix3::CreateTranslation(Vector2{ 10.0f, -20.0f });
+
+	std::vector<Vector2> transformed(count);
+	std::vector<Vector2> integrated(count);
+	std::vector<Vector2> mins(count);
+	std::vector<Vector2> maxs(count);
+	std::vector<float> sins(count);
+	std::vector<float> coss(count);
+
+	// Scalar results, every SIMD level has to match them to rounding
+	// (the scalar code may be built with fused multiply-adds, the kernels aren't)
+	Math::SimdLevel best = Math::BestSimdLevel();
+	Math::SetSimdLevel(Math::ESimdScalar);
+	std::vector<Vector2> refTransformed(count);
+	std::vector<Vector2> refIntegrated = points;
+	std::vector<Vector2> refMins(count);
+	std::vector<Vector2> refMaxs(count);
+	std::vector<float> refSins(count);
+	std::vector<float> refCoss(count);
+	Math::TransformPoints(mat, points.data(), refTransformed.data(), count);
+	Math::Integrate(refIntegrated.data(), velocities.data(), 1.0f / 60.0f, count);
+	Math::ComputeBounds(points.data(), halfExtents.data(), refMins.data(), refMaxs.data(), count);
+	Math::SinCos(angles.data(), refSins.data(), refCoss.data(), count);
+
+	// Differences can only come from rounding, so allow a few ulps of the
+	// largest values involved (coordinates run to a couple of thousand, and
+	// sums of products can cancel down to much less than that)
+	const float posTolerance = 1e-3f;
+	const float trigTolerance = 1e-6f;
+	auto close = [](float a, float b, float tolerance) {
+		return Math::Abs(a - b) <= tolerance;
+	};
+	auto closeVec = [&close, posTolerance](const Vector2& a, const Vector2& b) {
+		return close(a.x, b.x, posTolerance) && close(a.y, b.y, posTolerance);
+	};
+
+	int mismatches = 0;
+	for (int level = Math::ESimdScalar; level <= best; level++) {
+		Math::SetSimdLevel(static_cast<Math::SimdLevel>(level));
+		const char* suffix = level == Math::ESimdScalar ? "" : Math::SimdLevelName(Math::GetSimdLevel());
+		char name[32];
+
+		Measure measure = StartMeasure();
+		for (int frame = 0; frame < frames; frame++) {
+			Math::TransformPoints(mat, points.data(), transformed.data(), count);
+		}
+		snprintf(name, sizeof(name), "Transform%s", suffix);
+		Report(name, count, static_cast<long long>(count) * frames, measure);
+
+		integrated = points;
+		measure = StartMeasure();
+		for (int frame = 0; frame < frames; frame++) {
+			Math::Integrate(integrated.data(), velocities.data(), 1.0f / 60.0f, count);
+		}
+		snprintf(name, sizeof(name), "Integrate%s", suffix);
+		Report(name, count, static_cast<long long>(count) * frames, measure);
+
+		measure = StartMeasure();
+		for (int frame = 0; frame < frames; frame++) {
+			Math::ComputeBounds(points.data(), halfExtents.data(), mins.data(), maxs.data(), count);
+		}
+		snprintf(name, sizeof(name), "Bounds%s", suffix);
+		Report(name, count, static_cast<long long>(count) * frames, measure);
+
+		measure = StartMeasure();
+		for (int frame = 0; frame < frames; frame++) {
+			Math::SinCos(angles.data(), sins.data(), coss.data(), count);
+		}
+		snprintf(name, sizeof(name), "SinCos%s", suffix);
+		Report(name, count, static_cast<long long>(count) * frames, measure);
+
+		// One integration step from the start to compare
+		integrated = points;
+		Math::Integrate(integrated.data(), velocities.data(), 1.0f / 60.0f, count);
+
+		for (int i = 0; i < count; i++) {
+			if (!closeVec(transformed[i], refTransformed[i])
+				|| !closeVec(integrated[i], refIntegrated[i])
+				|| !closeVec(mins[i], refMins[i])
+				|| !closeVec(maxs[i], refMaxs[i])
+				|| !close(sins[i], refSins[i], trigTolerance)
+				|| !close(coss[i], refCoss[i], trigTolerance))
+			{
+				mismatches++;
+			}
+		}
+	}
+	Math::SetSimdLevel(best);
+
+	// The cmath versions for comparison
+	Measure measure = StartMeasure();
+	for (int frame = 0; frame < frames; frame++) {
+		for (int i = 0; i < count; i++) {
+			sins[i] = std::sin(angles[i]);
+			coss[i] = std::cos(angles[i]);
+		}
+	}
+	Report("SinCosCmath", count, static_cast<long long>(count) * frames, measure);
+
+	float sinError = 0.0f;
+	float cosError = 0.0f;
+	for (int i = 0; i < count; i++) {
+		sinError = Math::Max(sinError, Math::Abs(refSins[i] - sins[i]));
+		cosError = Math::Max(cosError, Math::Abs(refCoss[i] - coss[i]));
+	}
+
+	SDL_Log("  FastSin/FastCos max error %.2e / %.2e against cmath, %d points differ between SIMD and scalar",
+		sinError,
+		cosError,
+		mismatches
+	);
+	if (sinError > 1e-6f || cosError > 1e-6f || mismatches > 0) {
+		SDL_Log("  Math batch results out of bounds");
+		return false;
+	}
+
+	return true;
+}
+
+void Benchmark::SpriteDraw(int count, int frames) {
+	// Same scene with every actor still, then every actor moving
+	const bool movingModes[] = { false, true };
+	for (bool moving : movingModes) {
+		Game game;
+		game.SetHeadlessRendering(true);
+		if (StartGame(game)) {
+			std::vector<TextureHandle> walk = SkeletonFrames(game);
+
+			std::uniform_real_distribution<float> coord(0.0f, 1024.0f);
+			for (int i = 0; i < count; i++) {
+				Vector2 velocity = moving ? Vector2{ 10.0f, 5.0f } : Vector2::Zero;
+				MoverActor* actor = new MoverActor(&game, velocity);
+				actor->SetPosition(Vector2{ coord(Random()), coord(Random()) });
+				actor->SetRotation(0.1f * (i % 8));
+				SpriteComponent* sprite = new SpriteComponent(actor, i % 4);
+				sprite->SetTexture(walk[i % walk.size()]);
+			}
+
+			Measure measure = StartMeasure();
+			game.RunFrames(frames);
+			Report(moving ? "SpriteDrawMoving" : "SpriteDrawStatic", count, static_cast<long long>(count) * frames, measure);
+		}
+		game.Shutdown();
+	}
+}
+
+void Benchmark::Culling(int count, int frames) {
+	Game game;
+	game.SetHeadlessRendering(true);
+	if (StartGame(game)) {
+		std::vector<TextureHandle> walk = SkeletonFrames(game);
+
+		// A level 8 screens wide and 8 high, the camera pans across it
+		const float levelW = Game::ScreenWidth * 8.0f;
+		const float levelH = Game::ScreenHeight * 8.0f;
+		std::uniform_real_distribution<float> posX(0.0f, levelW);
+		std::uniform_real_distribution<float> posY(0.0f, levelH);
+		for (int i = 0; i < count; i++) {
+			Actor* actor = new Actor(&game);
+			actor->SetPosition(Vector2{ posX(Random()), posY(Random()) });
+			SpriteComponent* sprite = new SpriteComponent(actor, i % 4);
+			sprite->SetTexture(walk[i % walk.size()]);
+		}
+
+		Camera* camera = game.GetCamera();
+		Measure measure = StartMeasure();
+		for (int frame = 0; frame < frames; frame++) {
+			camera->SetPosition(Vector2{ frame * 32.0f, frame * 24.0f });
+			game.RunFrames(1);
+		}
+		Report("Culling", count, static_cast<long long>(count) * frames, measure);
+
+		const Camera::Stats& stats = camera->GetFrameStats();
+		SDL_Log("  last frame: %lld sprites submitted, %lld culled",
+			stats.mSubmitted,
+			stats.mCulled
+		);
+	}
+	game.Shutdown();
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <string>
+
+// Headless benchmarks for the engine's hot paths (run with --bench, or the
+// ChapterTwoBench executable from CMakeLists.txt)
+// Each one reports ns per op plus heap and pool allocations per op,
+// the results can be written out as JSON for regression tracking.
+// Heap allocations are only counted by the benchmark executable, which links
+// BenchmarkAllocator.cpp (the game keeps the default allocator).
+namespace Benchmark
+{
+	// Returns how many heap allocations have been made so far
+	using HeapCounter = long long (*)();
+	// Installed by the counting allocator (nullptr reports heap allocations as n/a)
+	void SetHeapCounter(HeapCounter counter);
+
+	// Run every benchmark and log the results
+	// (also written to jsonFile if it isn't nullptr)
+	// Returns false if a benchmark's results failed their checks or the JSON
+	// couldn't be written (the rest still run)
+	bool RunAll(const char* jsonFile = nullptr);
+	// Write every result so far as JSON
+	bool WriteJSON(const std::string& fileName);
+
+	// Sorted insertion into Game's sprite list (one sprite component per op)
+	void AddSprite(int count);
+	// Delete actors / sprite components in random order
+	void RemoveActor(int count);
+	void RemoveSprite(int count);
+	// Components with mixed update orders added to each of count actors
+	void AddComponent(int count, int componentsPerActor = 8);
+	// Component updates called directly, one op per component per frame
+	// (AnimUpdate also times switching clip by id before each update)
+	void AnimUpdate(int count, int frames = 60);
+	void BGUpdate(int count, int frames = 60);
+	// Parallax layers in components of 8, updated directly (one op per layer
+	// per frame), then whole rendered frames of one 8 layer component
+	void Parallax(int count, int frames = 60);
+	// Whole headless frames, one op per actor per frame
+	void HeadlessFrame(int count, int frames = 60);
+	// Whole rendered frames of rotated sprites, with every actor still and
+	// then every actor moving (still actors reuse their cached transforms)
+	void SpriteDraw(int count, int frames = 60);
+	// Whole rendered frames of a level 64 screens in area with the camera
+	// panning across it (most sprites are culled)
+	void Culling(int count, int frames = 60);
+
+	// Spawn and kill actors at a steady rate on top of a live population
+	void ActorChurn(int actorsPerSecond = 100000, int population = 10000, int seconds = 1);
+
+	// Move entities with a velocity, as Actor subclasses vs EntityWorld pools
+	void EntityUpdate(int count = 100000, int frames = 60);
+
+	// Actor update spread over 1, 2, 4 and 8 job threads
+	void ParallelUpdate(int count = 100000, int frames = 60);
+
+	// Broad phase over count actors at a fixed density: grid update, pair and
+	// radius queries, and all-pairs testing for comparison (ops are per actor)
+	void Collision(int count, int frames = 10);
+
+	// Load a size x size tile map from CSV and from the converted binary,
+	// then draw it scrolling (one op per frame, the cost shouldn't depend on size)
+	// and render whole frames of it tile by tile and through cached chunks
+	void TileMap(int size, int frames = 60);
+
+	// Math batch operations at every SIMD level the CPU has, plus std::sin/cos
+	// (checks FastSin/FastCos accuracy and that SIMD matches scalar to rounding,
+	// false if they're out of bounds)
+	bool MathBatch(int count, int frames = 100);
+}
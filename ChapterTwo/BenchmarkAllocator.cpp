@@ -0,0 +1,68 @@
+#include "Benchmark.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Counting replacement for the global allocator, linked into the benchmark
+// executable only so the game keeps the default allocator
+// (Every plain form is replaced so allocations and frees always pair up)
+namespace
+{
+	std::atomic<long long> sHeapAllocations(0);
+
+	long long HeapAllocations() {
+		return sHeapAllocations.load();
+	}
+
+	// Hook the counter up before main runs
+	struct InstallCounter {
+		InstallCounter() {
+			Benchmark::SetHeapCounter(&HeapAllocations);
+		}
+	} sInstallCounter;
+}
+
+void* operator new(size_t size) {
+	sHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* ptr = malloc(size ? size : 1)) {
+		return ptr;
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+	sHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+	return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept {
+	return operator new(size, tag);
+}
+
+void operator delete(void* ptr) noexcept {
+	free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+	free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+	free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+	free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+	free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+	free(ptr);
+}
@@ -0,0 +1,69 @@
+#include "Camera.h"
+#include <cmath>
+
+Camera::Camera(float viewWidth, float viewHeight)
+	: mPosition(Vector2::Zero)
+	, mViewSize(Vector2{ viewWidth, viewHeight })
+	, mCullMargin(0.0f)
+	, mFrameStats{}
+	, mTotalStats{}
+{}
+
+void Camera::CenterOn(const Vector2& point) {
+	mPosition = point - mViewSize * 0.5f;
+}
+
+SDL_Rect Camera::WorldToScreen(const SDL_Rect& world) const {
+	// Whole pixel camera moves, so neighbouring rects stay seamless
+	int offsetX = static_cast<int>(std::floor(mPosition.x));
+	int offsetY = static_cast<int>(std::floor(mPosition.y));
+	return SDL_Rect{ world.x - offsetX, world.y - offsetY, world.w, world.h };
+}
+
+bool Camera::IsVisible(const SDL_Rect& world) const {
+	return IsOnScreen(WorldToScreen(world));
+}
+
+bool Camera::IsOnScreen(const SDL_Rect& screen) const {
+	float left = -mCullMargin;
+	float top = -mCullMargin;
+	float right = mViewSize.x + mCullMargin;
+	float bottom = mViewSize.y + mCullMargin;
+
+	return screen.x < right && screen.x + screen.w > left
+		&& screen.y < bottom && screen.y + screen.h > top;
+}
+
+bool Camera::Submit(const SDL_Rect& world) {
+	return SubmitScreen(WorldToScreen(world));
+}
+
+bool Camera::SubmitScreen(const SDL_Rect& screen) {
+	if (IsOnScreen(screen)) {
+		mFrameStats.mSubmitted++;
+		return true;
+	}
+
+	mFrameStats.mCulled++;
+	return false;
+}
+
+void Camera::BeginFrame() {
+	mTotalStats.mSubmitted += mFrameStats.mSubmitted;
+	mTotalStats.mCulled += mFrameStats.mCulled;
+	mFrameStats = Stats{};
+}
+
+void Camera::LogStats(int numFrames) const {
+	long long submitted = mTotalStats.mSubmitted + mFrameStats.mSubmitted;
+	long long culled = mTotalStats.mCulled + mFrameStats.mCulled;
+	if (numFrames <= 0 || submitted + culled == 0) {
+		return;
+	}
+
+	SDL_Log("Camera: per frame %.1f draws submitted, %.1f culled (%.1f%% culled)",
+		static_cast<double>(submitted) / numFrames,
+		static_cast<double>(culled) / numFrames,
+		100.0 * culled / (submitted + culled)
+	);
+}
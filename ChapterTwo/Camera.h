@@ -0,0 +1,55 @@
+#pragma once
+#include "SDL.h"
+#include "Math.h"
+
+// The part of the world that's on screen.
+// World positions are drawn at (position - camera position), and draws whose
+// bounds fall outside the view (plus a margin) are culled before they reach
+// the sprite batch. Counts what was submitted and culled each frame.
+class Camera
+{
+public:
+	Camera(float viewWidth, float viewHeight);
+
+	// Top left corner of the view in world space
+	const Vector2& GetPosition() const { return mPosition; };
+	void SetPosition(const Vector2& position) { mPosition = position; };
+	// Move so the point is in the middle of the view
+	void CenterOn(const Vector2& point);
+
+	const Vector2& GetViewSize() const { return mViewSize; };
+	void SetViewSize(const Vector2& size) { mViewSize = size; };
+	// Distance outside the view still treated as visible (in world units)
+	void SetCullMargin(float margin) { mCullMargin = margin; };
+
+	// World rect to screen rect
+	SDL_Rect WorldToScreen(const SDL_Rect& world) const;
+	// Does the world space rect overlap the view (doesn't count)
+	bool IsVisible(const SDL_Rect& world) const;
+	// Same for a rect already in screen space (e.g. backgrounds)
+	bool IsOnScreen(const SDL_Rect& screen) const;
+	// Cull tests for a draw, count it as submitted or culled
+	bool Submit(const SDL_Rect& world);
+	bool SubmitScreen(const SDL_Rect& screen);
+
+	// Start a frame's counts (totals carry on)
+	void BeginFrame();
+
+	struct Stats {
+		long long mSubmitted;
+		long long mCulled;
+	};
+
+	// Last (or current) frame and totals since startup
+	const Stats& GetFrameStats() const { return mFrameStats; };
+	const Stats& GetTotalStats() const { return mTotalStats; };
+	void LogStats(int numFrames) const;
+
+private:
+	Vector2 mPosition;
+	Vector2 mViewSize;
+	float mCullMargin;
+
+	Stats mFrameStats;
+	Stats mTotalStats;
+};
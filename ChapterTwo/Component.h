@@ -1,4 +1,7 @@
 #pragma once
+#include "ObjectPool.h"
+#include <cstddef>
+
 class Component 
 {
 public:
@@ -9,6 +12,10 @@ public:
 	// Destructor
 	virtual ~Component();
 
+	// Components come out of their own pool (subclasses declare their own
+	// OBJECT_POOL, or share the size class pools)
+	OBJECT_POOL(Component)
+
 	// Update this component by delta time
 	virtual void Update(float deltaTime);
 
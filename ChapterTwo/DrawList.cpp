@@ -0,0 +1,66 @@
+#include "DrawList.h"
+#include "SpriteComponent.h"
+#include <algorithm>
+
+DrawList::DrawList()
+	: mNumSprites(0)
+	, mNextSequence(0)
+{}
+
+void DrawList::Add(SpriteComponent* sprite) {
+	Layer& layer = mLayers[sprite->GetDrawOrder()];
+
+	sprite->mDrawSlot = static_cast<int>(layer.mSprites.size());
+	sprite->mDrawSequence = mNextSequence++;
+	sprite->mDrawLayer = &layer;
+	layer.mSprites.emplace_back(sprite);
+	layer.mDirty = true;
+	mNumSprites++;
+}
+
+void DrawList::Remove(SpriteComponent* sprite) {
+	auto iter = mLayers.find(sprite->GetDrawOrder());
+	if (iter == mLayers.end() || sprite->mDrawSlot < 0) {
+		return;
+	}
+
+	// Swap with the last sprite in the layer and pop
+	std::vector<SpriteComponent*>& sprites = iter->second.mSprites;
+	SpriteComponent* last = sprites.back();
+	sprites[sprite->mDrawSlot] = last;
+	last->mDrawSlot = sprite->mDrawSlot;
+	sprites.pop_back();
+	sprite->mDrawSlot = -1;
+	sprite->mDrawLayer = nullptr;
+	mNumSprites--;
+
+	if (sprites.empty()) {
+		mLayers.erase(iter);
+	}
+	else {
+		iter->second.mDirty = true;
+	}
+}
+
+void DrawList::Sort() {
+	for (auto& iter : mLayers) {
+		Layer& layer = iter.second;
+		if (!layer.mDirty) {
+			continue;
+		}
+
+		// Group by texture, then keep insertion order (never heap addresses,
+		// which would change the stacking from run to run)
+		std::sort(layer.mSprites.begin(), layer.mSprites.end(),
+			[](const SpriteComponent* a, const SpriteComponent* b) {
+				uint32_t idA = a->GetSortId();
+				uint32_t idB = b->GetSortId();
+				return idA != idB ? idA < idB : a->mDrawSequence < b->mDrawSequence;
+			});
+
+		for (size_t i = 0; i < layer.mSprites.size(); i++) {
+			layer.mSprites[i]->mDrawSlot = static_cast<int>(i);
+		}
+		layer.mDirty = false;
+	}
+}
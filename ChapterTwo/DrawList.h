@@ -0,0 +1,39 @@
+#pragma once
+#include <atomic>
+#include <map>
+#include <vector>
+
+// Sprite components bucketed by draw order.
+// Adding and removing are O(1) within a layer (removal swaps with the last
+// sprite in the layer), plus a map lookup for the layer itself. A changed
+// layer is re-sorted by texture the next time Sort runs, so sprites that share
+// a texture (or an atlas page) end up next to each other and batch together.
+// Within a layer sprites are ordered by the texture's batch id and then by
+// when they were added, so the stacking is the same every run.
+class DrawList
+{
+public:
+	struct Layer {
+		std::vector<class SpriteComponent*> mSprites;
+		// Sprites added/removed or retextured since the last sort
+		// (Sprites can change texture while updating on a job thread)
+		std::atomic<bool> mDirty{ false };
+	};
+
+	DrawList();
+
+	void Add(class SpriteComponent* sprite);
+	void Remove(class SpriteComponent* sprite);
+
+	// Re-sort any layers that changed (once per frame, before drawing)
+	void Sort();
+	// Layers by ascending draw order
+	const std::map<int, Layer>& GetLayers() const { return mLayers; };
+	int GetNumSprites() const { return mNumSprites; };
+
+private:
+	std::map<int, Layer> mLayers;
+	int mNumSprites;
+	// Insertion order, the tiebreak between sprites with the same texture
+	unsigned mNextSequence;
+};
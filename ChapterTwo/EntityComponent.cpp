@@ -0,0 +1,33 @@
+#include "EntityComponent.h"
+#include "Actor.h"
+#include "Game.h"
+
+EntityComponent::EntityComponent(Actor* owner)
+	: Component(owner)
+	, mWorld(owner->GetGame()->GetWorld())
+{
+	mEntity = mWorld->CreateEntity();
+	mWorld->AddTransform(
+		mEntity,
+		mOwner->GetPosition(),
+		mOwner->GetScale(),
+		mOwner->GetRotation()
+	);
+	mWorld->BindActor(mEntity, mOwner);
+}
+
+EntityComponent::~EntityComponent() {
+	mWorld->DestroyEntity(mEntity);
+}
+
+void EntityComponent::SetVelocity(const Vector2& velocity, float angularVelocity) {
+	mWorld->AddVelocity(mEntity, velocity, angularVelocity);
+}
+
+void EntityComponent::SetSprite(const TextureHandle& texture, int drawOrder) {
+	mWorld->AddSprite(mEntity, texture, drawOrder);
+}
+
+void EntityComponent::SetAnimation(int clip, float fps) {
+	mWorld->AddAnimation(mEntity, clip, fps);
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include "Component.h"
+#include "EntityWorld.h"
+
+// Adapter that gives an actor an entity in the game's EntityWorld.
+// The actor keeps working as normal, but anything set through this component
+// (velocity, sprite, animation) lives in the world's pools and is updated by
+// its systems; the actor's transform is synced in and out each frame.
+class EntityComponent : public Component
+{
+public:
+	OBJECT_POOL(EntityComponent)
+	EntityComponent(class Actor* owner);
+	~EntityComponent();
+
+	Entity GetEntity() const { return mEntity; };
+
+	void SetVelocity(const Vector2& velocity, float angularVelocity = 0.0f);
+	void SetSprite(const TextureHandle& texture, int drawOrder = 100);
+	// Clip is an id from the game's AnimationRegistry
+	void SetAnimation(int clip, float fps = 24.0f);
+
+private:
+	class EntityWorld* mWorld;
+	Entity mEntity;
+};
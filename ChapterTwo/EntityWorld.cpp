@@ -0,0 +1,429 @@
+#include "EntityWorld.h"
+#include "AnimationRegistry.h"
+#include "Actor.h"
+#include "SpriteBatch.h"
+#include "Camera.h"
+#include "InputLog.h"
+#include <algorithm>
+#include <cmath>
+
+int EntityWorld::SparseSet::Insert(uint32_t index) {
+	if (index >= mSparse.size()) {
+		mSparse.resize(index + 1, -1);
+	}
+
+	int slot = static_cast<int>(mDense.size());
+	mSparse[index] = slot;
+	mDense.emplace_back(index);
+
+	return slot;
+}
+
+int EntityWorld::SparseSet::Erase(uint32_t index) {
+	int slot = Find(index);
+	if (slot < 0) {
+		return -1;
+	}
+
+	// Last entry fills the hole
+	uint32_t last = mDense.back();
+	mDense[slot] = last;
+	mSparse[last] = slot;
+	mDense.pop_back();
+	mSparse[index] = -1;
+
+	return slot;
+}
+
+EntityWorld::EntityWorld(const AnimationRegistry* animations)
+	: mNumAlive(0)
+	, mAnimationRegistry(animations)
+	, mDrawSortDirty(false)
+	, mDrawCursor(0)
+	, mDrawAlpha(1.0f)
+	, mDrawCamera(nullptr)
+{}
+
+void EntityWorld::Clear() {
+	mGenerations.clear();
+	mAlive.clear();
+	mFreeIndices.clear();
+	mNumAlive = 0;
+
+	mTransforms = TransformPool();
+	mVelocities = VelocityPool();
+	mSprites = SpritePool();
+	mAnimations = AnimationPool();
+	mActors = ActorPool();
+
+	mDrawSorted.clear();
+	mDrawSortDirty = false;
+	mDrawCursor = 0;
+}
+
+Entity EntityWorld::CreateEntity() {
+	uint32_t index;
+
+	if (!mFreeIndices.empty()) {
+		index = mFreeIndices.back();
+		mFreeIndices.pop_back();
+	}
+	else {
+		index = static_cast<uint32_t>(mGenerations.size());
+		mGenerations.emplace_back(0);
+		mAlive.emplace_back(false);
+	}
+
+	mAlive[index] = true;
+	mNumAlive++;
+
+	return Entity{ index, mGenerations[index] };
+}
+
+void EntityWorld::DestroyEntity(Entity entity) {
+	if (!IsAlive(entity)) {
+		return;
+	}
+
+	uint32_t index = entity.mIndex;
+
+	int slot = mTransforms.Erase(index);
+	if (slot >= 0) {
+		SwapPop(slot, mTransforms.mX, mTransforms.mY, mTransforms.mScale, mTransforms.mRotation,
+			mTransforms.mPrevX, mTransforms.mPrevY, mTransforms.mPrevRotation);
+	}
+
+	RemoveVelocity(entity);
+	RemoveSprite(entity);
+	RemoveAnimation(entity);
+	UnbindActor(entity);
+
+	// Bump the generation so old ids stop matching
+	mGenerations[index]++;
+	mAlive[index] = false;
+	mFreeIndices.emplace_back(index);
+	mNumAlive--;
+}
+
+bool EntityWorld::IsAlive(Entity entity) const {
+	return entity.mIndex < mGenerations.size()
+		&& mAlive[entity.mIndex]
+		&& mGenerations[entity.mIndex] == entity.mGeneration;
+}
+
+void EntityWorld::AddTransform(Entity entity, const Vector2& position, float scale, float rotation) {
+	int slot = mTransforms.Find(entity.mIndex);
+
+	if (slot < 0) {
+		slot = mTransforms.Insert(entity.mIndex);
+		mTransforms.mX.emplace_back();
+		mTransforms.mY.emplace_back();
+		mTransforms.mScale.emplace_back();
+		mTransforms.mRotation.emplace_back();
+		mTransforms.mPrevX.emplace_back();
+		mTransforms.mPrevY.emplace_back();
+		mTransforms.mPrevRotation.emplace_back();
+	}
+
+	mTransforms.mX[slot] = position.x;
+	mTransforms.mY[slot] = position.y;
+	mTransforms.mScale[slot] = scale;
+	mTransforms.mRotation[slot] = rotation;
+	// Nothing to interpolate from yet
+	mTransforms.mPrevX[slot] = position.x;
+	mTransforms.mPrevY[slot] = position.y;
+	mTransforms.mPrevRotation[slot] = rotation;
+}
+
+void EntityWorld::AddVelocity(Entity entity, const Vector2& velocity, float angularVelocity) {
+	int slot = mVelocities.Find(entity.mIndex);
+
+	if (slot < 0) {
+		slot = mVelocities.Insert(entity.mIndex);
+		mVelocities.mVX.emplace_back();
+		mVelocities.mVY.emplace_back();
+		mVelocities.mAngular.emplace_back();
+	}
+
+	mVelocities.mVX[slot] = velocity.x;
+	mVelocities.mVY[slot] = velocity.y;
+	mVelocities.mAngular[slot] = angularVelocity;
+}
+
+void EntityWorld::AddSprite(Entity entity, const TextureHandle& texture, int drawOrder) {
+	int slot = mSprites.Find(entity.mIndex);
+
+	if (slot < 0) {
+		slot = mSprites.Insert(entity.mIndex);
+		mSprites.mTexture.emplace_back();
+		mSprites.mDrawOrder.emplace_back();
+	}
+
+	mSprites.mTexture[slot] = texture;
+	mSprites.mDrawOrder[slot] = drawOrder;
+	mDrawSortDirty = true;
+}
+
+void EntityWorld::AddAnimation(Entity entity, int clip, float fps) {
+	const AnimationClip* animation = mAnimationRegistry ? mAnimationRegistry->GetClip(clip) : nullptr;
+	if (!animation) {
+		SDL_Log("EntityWorld: no animation clip %d", clip);
+		return;
+	}
+
+	int slot = mAnimations.Find(entity.mIndex);
+
+	if (slot < 0) {
+		slot = mAnimations.Insert(entity.mIndex);
+		mAnimations.mClip.emplace_back();
+		mAnimations.mFPS.emplace_back();
+		mAnimations.mFrame.emplace_back();
+		mAnimations.mShownFrame.emplace_back();
+	}
+
+	mAnimations.mClip[slot] = animation;
+	mAnimations.mFPS[slot] = fps;
+	mAnimations.mFrame[slot] = 0.0f;
+	mAnimations.mShownFrame[slot] = -1;
+}
+
+void EntityWorld::RemoveVelocity(Entity entity) {
+	int slot = mVelocities.Erase(entity.mIndex);
+	if (slot >= 0) {
+		SwapPop(slot, mVelocities.mVX, mVelocities.mVY, mVelocities.mAngular);
+	}
+}
+
+void EntityWorld::RemoveSprite(Entity entity) {
+	int slot = mSprites.Erase(entity.mIndex);
+	if (slot >= 0) {
+		SwapPop(slot, mSprites.mTexture, mSprites.mDrawOrder);
+		mDrawSortDirty = true;
+	}
+}
+
+void EntityWorld::RemoveAnimation(Entity entity) {
+	int slot = mAnimations.Erase(entity.mIndex);
+	if (slot >= 0) {
+		SwapPop(slot,
+			mAnimations.mClip,
+			mAnimations.mFPS,
+			mAnimations.mFrame,
+			mAnimations.mShownFrame
+		);
+	}
+}
+
+Vector2 EntityWorld::GetPosition(Entity entity) const {
+	int slot = mTransforms.Find(entity.mIndex);
+	return Vector2{ mTransforms.mX[slot], mTransforms.mY[slot] };
+}
+
+void EntityWorld::SetPosition(Entity entity, const Vector2& position) {
+	int slot = mTransforms.Find(entity.mIndex);
+	mTransforms.mX[slot] = position.x;
+	mTransforms.mY[slot] = position.y;
+}
+
+float EntityWorld::GetScale(Entity entity) const {
+	return mTransforms.mScale[mTransforms.Find(entity.mIndex)];
+}
+
+float EntityWorld::GetRotation(Entity entity) const {
+	return mTransforms.mRotation[mTransforms.Find(entity.mIndex)];
+}
+
+void EntityWorld::SetVelocity(Entity entity, const Vector2& velocity) {
+	int slot = mVelocities.Find(entity.mIndex);
+	if (slot < 0) {
+		AddVelocity(entity, velocity);
+		return;
+	}
+
+	mVelocities.mVX[slot] = velocity.x;
+	mVelocities.mVY[slot] = velocity.y;
+}
+
+void EntityWorld::BindActor(Entity entity, Actor* actor) {
+	int slot = mActors.Find(entity.mIndex);
+
+	if (slot < 0) {
+		slot = mActors.Insert(entity.mIndex);
+		mActors.mActor.emplace_back();
+	}
+
+	mActors.mActor[slot] = actor;
+}
+
+void EntityWorld::UnbindActor(Entity entity) {
+	int slot = mActors.Erase(entity.mIndex);
+	if (slot >= 0) {
+		SwapPop(slot, mActors.mActor);
+	}
+}
+
+void EntityWorld::Update(float deltaTime) {
+	// Keep where this update starts from (same sizes every time, so no allocation)
+	mTransforms.mPrevX = mTransforms.mX;
+	mTransforms.mPrevY = mTransforms.mY;
+	mTransforms.mPrevRotation = mTransforms.mRotation;
+
+	SyncFromActors();
+	UpdateMovement(deltaTime);
+	UpdateAnimation(deltaTime);
+	SyncToActors();
+}
+
+void EntityWorld::SyncFromActors() {
+	// Pick up whatever the actors did to themselves this frame
+	for (int i = 0; i < mActors.Size(); i++) {
+		int t = mTransforms.Find(mActors.mDense[i]);
+		const Actor* actor = mActors.mActor[i];
+
+		mTransforms.mX[t] = actor->GetPosition().x;
+		mTransforms.mY[t] = actor->GetPosition().y;
+		mTransforms.mScale[t] = actor->GetScale();
+		mTransforms.mRotation[t] = actor->GetRotation();
+	}
+}
+
+void EntityWorld::UpdateMovement(float deltaTime) {
+	const int count = mVelocities.Size();
+	const uint32_t* entities = mVelocities.mDense.data();
+	const float* vx = mVelocities.mVX.data();
+	const float* vy = mVelocities.mVY.data();
+	const float* angular = mVelocities.mAngular.data();
+	float* x = mTransforms.mX.data();
+	float* y = mTransforms.mY.data();
+	float* rotation = mTransforms.mRotation.data();
+
+	for (int i = 0; i < count; i++) {
+		int t = mTransforms.mSparse[entities[i]];
+		x[t] += vx[i] * deltaTime;
+		y[t] += vy[i] * deltaTime;
+		rotation[t] += angular[i] * deltaTime;
+	}
+}
+
+void EntityWorld::UpdateAnimation(float deltaTime) {
+	const int count = mAnimations.Size();
+
+	for (int i = 0; i < count; i++) {
+		const std::vector<TextureHandle>& frames = mAnimations.mClip[i]->mFrames;
+		if (frames.empty()) {
+			continue;
+		}
+
+		// Advance and wrap the current frame (either way, fps can be negative)
+		float numFrames = static_cast<float>(frames.size());
+		float frame = std::fmod(mAnimations.mFrame[i] + mAnimations.mFPS[i] * deltaTime, numFrames);
+		if (frame < 0.0f) {
+			frame += numFrames;
+		}
+		// A tiny negative frame rounds up to numFrames when wrapped
+		if (frame >= numFrames) {
+			frame = 0.0f;
+		}
+		mAnimations.mFrame[i] = frame;
+
+		// Only touch the sprite when the frame changes
+		int shown = static_cast<int>(frame);
+		if (shown != mAnimations.mShownFrame[i]) {
+			mAnimations.mShownFrame[i] = shown;
+
+			int s = mSprites.Find(mAnimations.mDense[i]);
+			if (s >= 0) {
+				mSprites.mTexture[s] = frames[shown];
+			}
+		}
+	}
+}
+
+void EntityWorld::SyncToActors() {
+	for (int i = 0; i < mActors.Size(); i++) {
+		int t = mTransforms.Find(mActors.mDense[i]);
+		Actor* actor = mActors.mActor[i];
+
+		actor->SetPosition(Vector2{ mTransforms.mX[t], mTransforms.mY[t] });
+		actor->SetRotation(mTransforms.mRotation[t]);
+	}
+}
+
+void EntityWorld::BeginDraw(float alpha, Camera* camera) {
+	mDrawAlpha = alpha;
+	mDrawCamera = camera;
+
+	if (mDrawSortDirty) {
+		mDrawSorted.resize(mSprites.Size());
+		for (int i = 0; i < mSprites.Size(); i++) {
+			mDrawSorted[i] = i;
+		}
+		std::stable_sort(mDrawSorted.begin(), mDrawSorted.end(), [this](int a, int b) {
+			return mSprites.mDrawOrder[a] < mSprites.mDrawOrder[b];
+		});
+		mDrawSortDirty = false;
+	}
+
+	mDrawCursor = 0;
+}
+
+void EntityWorld::DrawUpTo(SpriteBatch* batch, int drawOrder) {
+	// Entity sprites with a lower order than the next component sprite go first
+	while (mDrawCursor < mDrawSorted.size()
+		&& mSprites.mDrawOrder[mDrawSorted[mDrawCursor]] < drawOrder)
+	{
+		DrawSprite(batch, mDrawSorted[mDrawCursor++]);
+	}
+}
+
+void EntityWorld::EndDraw(SpriteBatch* batch) {
+	while (mDrawCursor < mDrawSorted.size()) {
+		DrawSprite(batch, mDrawSorted[mDrawCursor++]);
+	}
+}
+
+void EntityWorld::DrawSprite(SpriteBatch* batch, int slot) {
+	const TextureHandle& texture = mSprites.mTexture[slot];
+	int t = mTransforms.Find(mSprites.mDense[slot]);
+	if (!texture || t < 0) {
+		return;
+	}
+
+	float scale = mTransforms.mScale[t];
+	float x = mTransforms.mPrevX[t] + (mTransforms.mX[t] - mTransforms.mPrevX[t]) * mDrawAlpha;
+	float y = mTransforms.mPrevY[t] + (mTransforms.mY[t] - mTransforms.mPrevY[t]) * mDrawAlpha;
+	float rotation = mTransforms.mPrevRotation[t] + (mTransforms.mRotation[t] - mTransforms.mPrevRotation[t]) * mDrawAlpha;
+
+	SDL_Rect r;
+	r.w = static_cast<int>(texture.GetWidth() * scale);
+	r.h = static_cast<int>(texture.GetHeight() * scale);
+	r.x = static_cast<int>(x - r.w / 2);
+	r.y = static_cast<int>(y - r.h / 2);
+
+	if (mDrawCamera) {
+		// Square around the rect covers it at any rotation
+		int size = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(r.w * r.w + r.h * r.h))));
+		SDL_Rect bounds{ r.x + (r.w - size) / 2, r.y + (r.h - size) / 2, size, size };
+		if (!mDrawCamera->Submit(bounds)) {
+			return;
+		}
+		r = mDrawCamera->WorldToScreen(r);
+	}
+
+	batch->Draw(texture, r, rotation);
+}
+
+uint64_t EntityWorld::HashState(uint64_t hash) const {
+	// Dense order is deterministic, it only depends on the order of creates and destroys
+	auto hashColumn = [&hash](const auto& column) {
+		if (!column.empty()) {
+			hash = InputLog::Hash(hash, column.data(), column.size() * sizeof(column[0]));
+		}
+	};
+	hashColumn(mTransforms.mX);
+	hashColumn(mTransforms.mY);
+	hashColumn(mTransforms.mScale);
+	hashColumn(mTransforms.mRotation);
+	hashColumn(mAnimations.mFrame);
+	return hash;
+}
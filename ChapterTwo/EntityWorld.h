@@ -0,0 +1,155 @@
+#pragma once
+#include "Math.h"
+#include "TextureCache.h"
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Entity id: slot in the pools' sparse arrays plus a generation,
+// so ids of destroyed entities don't alias whatever reuses the slot
+struct Entity {
+	uint32_t mIndex;
+	uint32_t mGeneration;
+};
+
+// Data-oriented storage for entities that need to be cheap in bulk.
+// Each component type lives in a dense structure-of-arrays pool and the
+// systems walk those arrays linearly instead of chasing Actor/Component pointers.
+// Actors can be bound to an entity (see EntityComponent) so their transform
+// round-trips through the pools each frame.
+class EntityWorld
+{
+public:
+	// Animation clip ids are looked up in animations (can be null if
+	// no entity is ever animated)
+	EntityWorld(const class AnimationRegistry* animations = nullptr);
+
+	// Destroy every entity
+	void Clear();
+
+	Entity CreateEntity();
+	// Removes the entity from every pool
+	void DestroyEntity(Entity entity);
+	bool IsAlive(Entity entity) const;
+	int GetNumEntities() const { return mNumAlive; };
+
+	// Add components (adding one that already exists overwrites it)
+	void AddTransform(Entity entity, const Vector2& position, float scale = 1.0f, float rotation = 0.0f);
+	void AddVelocity(Entity entity, const Vector2& velocity, float angularVelocity = 0.0f);
+	void AddSprite(Entity entity, const TextureHandle& texture, int drawOrder = 100);
+	// Clip is an AnimationRegistry id
+	void AddAnimation(Entity entity, int clip, float fps = 24.0f);
+	void RemoveVelocity(Entity entity);
+	void RemoveSprite(Entity entity);
+	void RemoveAnimation(Entity entity);
+
+	// Transform access (entity must have a transform)
+	Vector2 GetPosition(Entity entity) const;
+	void SetPosition(Entity entity, const Vector2& position);
+	float GetScale(Entity entity) const;
+	float GetRotation(Entity entity) const;
+	void SetVelocity(Entity entity, const Vector2& velocity);
+
+	// Copy the actor's transform in before the systems run and back out after
+	void BindActor(Entity entity, class Actor* actor);
+	void UnbindActor(Entity entity);
+
+	// Run the systems (bound actors sync in, movement, animation, sync out)
+	void Update(float deltaTime);
+	// Hash of every transform and animation frame, chained through hash
+	// (used to check replays simulate the same thing)
+	uint64_t HashState(uint64_t hash) const;
+
+	// Entity sprites are drawn in between the component sprites by draw order:
+	// call DrawUpTo before each component sprite, then EndDraw for the rest
+	// (alpha interpolates between the previous update and the latest one)
+	// (Sprites are culled against and drawn relative to the camera, if there is one)
+	void BeginDraw(float alpha = 1.0f, class Camera* camera = nullptr);
+	void DrawUpTo(class SpriteBatch* batch, int drawOrder);
+	void EndDraw(class SpriteBatch* batch);
+
+private:
+	// Maps entity index <-> dense slot, shared by every pool
+	class SparseSet
+	{
+	public:
+		int Find(uint32_t index) const {
+			return index < mSparse.size() ? mSparse[index] : -1;
+		}
+		int Size() const { return static_cast<int>(mDense.size()); }
+		// Returns the slot for a new entry (the columns must be grown by the caller)
+		int Insert(uint32_t index);
+		// Returns the vacated slot (the last entry moves into it) or -1
+		int Erase(uint32_t index);
+
+		std::vector<int> mSparse;
+		std::vector<uint32_t> mDense;
+	};
+
+	// Move the last element of every column into slot and shrink them
+	template <typename... Columns>
+	static void SwapPop(int slot, Columns&... columns) {
+		((columns[slot] = std::move(columns.back()), columns.pop_back()), ...);
+	}
+
+	struct TransformPool : SparseSet {
+		std::vector<float> mX;
+		std::vector<float> mY;
+		std::vector<float> mScale;
+		std::vector<float> mRotation;
+		// As of the start of the last update, for interpolated drawing
+		std::vector<float> mPrevX;
+		std::vector<float> mPrevY;
+		std::vector<float> mPrevRotation;
+	};
+
+	struct VelocityPool : SparseSet {
+		std::vector<float> mVX;
+		std::vector<float> mVY;
+		std::vector<float> mAngular;
+	};
+
+	struct SpritePool : SparseSet {
+		std::vector<TextureHandle> mTexture;
+		std::vector<int> mDrawOrder;
+	};
+
+	struct AnimationPool : SparseSet {
+		// Resolved from the registry when added (clips never move)
+		std::vector<const struct AnimationClip*> mClip;
+		std::vector<float> mFPS;
+		std::vector<float> mFrame;
+		std::vector<int> mShownFrame;
+	};
+
+	struct ActorPool : SparseSet {
+		std::vector<class Actor*> mActor;
+	};
+
+	void SyncFromActors();
+	void UpdateMovement(float deltaTime);
+	void UpdateAnimation(float deltaTime);
+	void SyncToActors();
+	void DrawSprite(class SpriteBatch* batch, int slot);
+
+	std::vector<uint32_t> mGenerations;
+	std::vector<bool> mAlive;
+	std::vector<uint32_t> mFreeIndices;
+	int mNumAlive;
+
+	TransformPool mTransforms;
+	VelocityPool mVelocities;
+	SpritePool mSprites;
+	AnimationPool mAnimations;
+	ActorPool mActors;
+
+	// Where AddAnimation looks up clip ids
+	const class AnimationRegistry* mAnimationRegistry;
+
+	// Sprite slots sorted by draw order, rebuilt when sprites are added/removed
+	std::vector<int> mDrawSorted;
+	bool mDrawSortDirty;
+	size_t mDrawCursor;
+	float mDrawAlpha;
+	class Camera* mDrawCamera;
+};
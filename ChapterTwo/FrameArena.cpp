@@ -0,0 +1,72 @@
+#include "FrameArena.h"
+#include "SDL.h"
+#include <new>
+
+FrameArena::FrameArena(size_t capacity)
+	: mBuffer(static_cast<char*>(::operator new(capacity)))
+	, mCapacity(capacity)
+	, mUsed(0)
+	, mRequested(0)
+	, mStats{}
+{
+	mStats.mCapacity = capacity;
+}
+
+FrameArena::~FrameArena() {
+	Reset();
+	::operator delete(mBuffer);
+}
+
+void* FrameArena::Allocate(size_t bytes, size_t align) {
+	mStats.mAllocations++;
+	mRequested += bytes + align;
+
+	// Round up to the alignment (align is a power of two)
+	size_t offset = (mUsed + align - 1) & ~(align - 1);
+
+	if (offset + bytes > mCapacity) {
+		// Out of room, the heap covers the rest of this frame
+		mStats.mOverflows++;
+		void* block = ::operator new(bytes);
+		mOverflow.emplace_back(block);
+		return block;
+	}
+
+	mUsed = offset + bytes;
+	return mBuffer + offset;
+}
+
+void FrameArena::Reset() {
+	if (mRequested > mStats.mPeakUsed) {
+		mStats.mPeakUsed = mRequested;
+	}
+
+	if (!mOverflow.empty()) {
+		for (auto block : mOverflow) {
+			::operator delete(block);
+		}
+		mOverflow.clear();
+
+		// Make room for a frame like this one next time
+		size_t capacity = mCapacity;
+		while (capacity < mRequested) {
+			capacity *= 2;
+		}
+		::operator delete(mBuffer);
+		mBuffer = static_cast<char*>(::operator new(capacity));
+		mCapacity = capacity;
+		mStats.mCapacity = capacity;
+	}
+
+	mUsed = 0;
+	mRequested = 0;
+}
+
+void FrameArena::LogStats() const {
+	SDL_Log("FrameArena: %d allocations, %d overflowed, peak %zu of %zu bytes",
+		mStats.mAllocations,
+		mStats.mOverflows,
+		mStats.mPeakUsed,
+		mStats.mCapacity
+	);
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// Linear scratch memory that only lives for one frame.
+// Allocating bumps a pointer and nothing is freed individually,
+// Reset at the start of the frame throws the lot away. Main thread only.
+class FrameArena
+{
+public:
+	explicit FrameArena(size_t capacity = 64 * 1024);
+	~FrameArena();
+
+	void* Allocate(size_t bytes, size_t align = alignof(std::max_align_t));
+	// Forget everything allocated since the last Reset
+	// (Grows the buffer if the frame didn't fit)
+	void Reset();
+
+	struct Stats {
+		int mAllocations;
+		// Allocations that didn't fit and went to the heap
+		int mOverflows;
+		size_t mPeakUsed;
+		size_t mCapacity;
+	};
+	const Stats& GetStats() const { return mStats; };
+	void LogStats() const;
+
+private:
+	char* mBuffer;
+	size_t mCapacity;
+	size_t mUsed;
+	// Bytes asked for this frame, including overflow
+	size_t mRequested;
+	// Heap blocks handed out once the buffer ran out, freed on Reset
+	std::vector<void*> mOverflow;
+	Stats mStats;
+};
+
+// Lets standard containers allocate from a FrameArena
+// e.g. std::vector<Actor*, ArenaAllocator<Actor*>> v{ ArenaAllocator<Actor*>(&arena) };
+template <typename T>
+class ArenaAllocator
+{
+public:
+	using value_type = T;
+
+	explicit ArenaAllocator(FrameArena* arena) : mArena(arena) {};
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other) : mArena(other.mArena) {};
+
+	T* allocate(size_t n) {
+		return static_cast<T*>(mArena->Allocate(n * sizeof(T), alignof(T)));
+	}
+	// Freed with the rest of the frame
+	void deallocate(T*, size_t) {}
+
+	template <typename U>
+	bool operator==(const ArenaAllocator<U>& other) const { return mArena == other.mArena; };
+	template <typename U>
+	bool operator!=(const ArenaAllocator<U>& other) const { return mArena != other.mArena; };
+
+private:
+	template <typename U>
+	friend class ArenaAllocator;
+
+	FrameArena* mArena;
+};
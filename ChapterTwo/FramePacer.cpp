@@ -0,0 +1,99 @@
+#include "FramePacer.h"
+#include "SDL.h"
+#include <cmath>
+#include <thread>
+
+FramePacer::FramePacer()
+	: mTargetFPS(60.0f)
+	, mSpinThreshold(0.0005f)
+	, mStats{}
+	, mFrameTimeM2(0.0)
+{
+	Reset();
+}
+
+void FramePacer::SetTargetFPS(float fps) {
+	mTargetFPS = fps > 0.0f ? fps : 0.0f;
+}
+
+void FramePacer::Reset() {
+	mLastFrame = Clock::now();
+	mStats = Stats{};
+	mFrameTimeM2 = 0.0;
+}
+
+float FramePacer::WaitForNextFrame() {
+	if (mTargetFPS > 0.0f) {
+		auto deadline = mLastFrame + std::chrono::duration_cast<Clock::duration>(
+			std::chrono::duration<double>(1.0 / mTargetFPS)
+		);
+		auto spinFrom = deadline - std::chrono::duration_cast<Clock::duration>(
+			std::chrono::duration<double>(mSpinThreshold)
+		);
+
+		// Sleep through most of the remaining time
+		// (SDL raises the Windows timer resolution to 1ms on init)
+		auto now = Clock::now();
+		if (now < spinFrom) {
+			std::this_thread::sleep_for(spinFrom - now);
+			auto woke = Clock::now();
+			mStats.mSleepTime += std::chrono::duration<double>(woke - now).count();
+			now = woke;
+		}
+
+		// Spin for the last fraction of a millisecond
+		auto spinStart = now;
+		while (now < deadline) {
+			now = Clock::now();
+		}
+		mStats.mSpinTime += std::chrono::duration<double>(now - spinStart).count();
+	}
+
+	auto now = Clock::now();
+	double frameTime = std::chrono::duration<double>(now - mLastFrame).count();
+	mLastFrame = now;
+
+	RecordFrame(frameTime);
+
+	return static_cast<float>(frameTime);
+}
+
+void FramePacer::RecordFrame(double frameTime) {
+	mStats.mFrames++;
+
+	if (mStats.mFrames == 1) {
+		mStats.mMinFrameTime = frameTime;
+		mStats.mMaxFrameTime = frameTime;
+	}
+	else {
+		mStats.mMinFrameTime = frameTime < mStats.mMinFrameTime ? frameTime : mStats.mMinFrameTime;
+		mStats.mMaxFrameTime = frameTime > mStats.mMaxFrameTime ? frameTime : mStats.mMaxFrameTime;
+	}
+
+	// Welford's online mean/variance
+	double delta = frameTime - mStats.mAvgFrameTime;
+	mStats.mAvgFrameTime += delta / mStats.mFrames;
+	mFrameTimeM2 += delta * (frameTime - mStats.mAvgFrameTime);
+	mStats.mJitter = std::sqrt(mFrameTimeM2 / mStats.mFrames);
+}
+
+void FramePacer::LogStats() const {
+	if (mStats.mFrames == 0) {
+		return;
+	}
+
+	double total = mStats.mAvgFrameTime * mStats.mFrames;
+
+	SDL_Log("FramePacer: %d frames at target %.1f fps", mStats.mFrames, mTargetFPS);
+	SDL_Log("  frame time avg %.3f ms, min %.3f ms, max %.3f ms, jitter %.3f ms",
+		mStats.mAvgFrameTime * 1000.0,
+		mStats.mMinFrameTime * 1000.0,
+		mStats.mMaxFrameTime * 1000.0,
+		mStats.mJitter * 1000.0
+	);
+	SDL_Log("  slept %.3f s (%.1f%% of run, CPU time saved vs busy-wait), spun %.3f s",
+		mStats.mSleepTime,
+		total > 0.0 ? 100.0 * mStats.mSleepTime / total : 0.0,
+		mStats.mSpinTime
+	);
+}
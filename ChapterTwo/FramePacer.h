@@ -0,0 +1,52 @@
+#pragma once
+#include <chrono>
+
+// Limits the frame rate without burning a core.
+// Sleeps for most of the remaining frame budget and only spins
+// for the last fraction of a millisecond to hit the deadline accurately.
+class FramePacer
+{
+public:
+	FramePacer();
+
+	// Target frame rate (0.0f for uncapped)
+	void SetTargetFPS(float fps);
+	float GetTargetFPS() const { return mTargetFPS; };
+	// How close to the deadline we stop sleeping and start spinning (in seconds)
+	void SetSpinThreshold(float seconds) { mSpinThreshold = seconds; };
+
+	// Restart the frame clock (call before the first frame)
+	void Reset();
+	// Wait until the next frame is due, returns seconds since the last frame
+	float WaitForNextFrame();
+
+	struct Stats {
+		int mFrames;
+		// Frame times (in seconds)
+		double mAvgFrameTime;
+		double mMinFrameTime;
+		double mMaxFrameTime;
+		// Standard deviation of the frame time
+		double mJitter;
+		// Time spent asleep (CPU time a busy-wait would have burned)
+		double mSleepTime;
+		// Time spent spinning before the deadline
+		double mSpinTime;
+	};
+
+	const Stats& GetStats() const { return mStats; };
+	void LogStats() const;
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	void RecordFrame(double frameTime);
+
+	Clock::time_point mLastFrame;
+	float mTargetFPS;
+	float mSpinThreshold;
+
+	Stats mStats;
+	// Running sum of squared differences from the mean (Welford)
+	double mFrameTimeM2;
+};
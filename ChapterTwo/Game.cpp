@@ -1,74 +1,158 @@
 #include "Game.h"
 #include "SDL_image.h"
 #include <algorithm>
+#include <cmath>
 #include "Actor.h"
 #include "SpriteComponent.h"
 #include "Ship.h"
-#include "BGSpriteComponent.h"
+#include "ParallaxComponent.h"
 #include "AnimSpriteComponent.h"
+#include "ObjectPool.h"
+#include "Profiler.h"
 
 Game::Game() :
+	mWorld(&mAnimations),
+	mCamera(static_cast<float>(ScreenWidth), static_cast<float>(ScreenHeight)),
 	mWindow(nullptr),
 	mRenderer(nullptr),
+	mHeadlessSurface(nullptr),
 	mIsRunning(true),
-	mUpdatingActors(false)
+	mUpdatingActors(false),
+	mNumThreads(0),
+	mParallelUpdate(false),
+	mHeadless(false),
+	mHeadlessRendering(false),
+	mFixedDeltaTime(0.0f),
+	mFrameCount(0),
+	mSimStep(1.0f / 60.0f),
+	mMaxSubSteps(8),
+	mAccumulator(0.0),
+	mInterpolation(1.0f),
+	mSkipRender(false),
+	mSkippedInARow(0),
+	mStepCount(0),
+	mSkippedRenders(0),
+	mDroppedTime(0.0),
+	mTransformsRecomputed(0),
+	mTransformsChecked(0),
+	mShip(nullptr)
 {}
 
 
 bool Game::Initialise() {
-	if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) != 0) {
+	if (mHeadless) {
+		// No display on headless machines, use SDL's dummy video driver
+		SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+	}
+
+	Uint32 subsystems = mHeadless ? SDL_INIT_VIDEO : (SDL_INIT_VIDEO | SDL_INIT_AUDIO);
+	if (SDL_Init(subsystems) != 0) {
 		SDL_Log("Unable to initialise SDL: %s", SDL_GetError());
 		return false;
 	}
 
-	mWindow = SDL_CreateWindow(
-		"Game Programming in C++ (Chapter 2)",
-		100,
-		100,
-		1024,
-		768,
-		0
-	);
+	if (mHeadless) {
+		// Software renderer drawing into an offscreen surface
+		// (still needed so textures can be created)
+		mHeadlessSurface = SDL_CreateRGBSurfaceWithFormat(
+			0,
+			ScreenWidth,
+			ScreenHeight,
+			32,
+			SDL_PIXELFORMAT_RGBA32
+		);
+
+		if (!mHeadlessSurface) {
+			SDL_Log("Unable to create headless surface: %s", SDL_GetError());
+			return false;
+		}
 
-	if (!mWindow) {
-		SDL_Log("Unable to create window: %s", SDL_GetError());
-		return false;
+		mRenderer = SDL_CreateSoftwareRenderer(mHeadlessSurface);
 	}
+	else {
+		mWindow = SDL_CreateWindow(
+			"Game Programming in C++ (Chapter 2)",
+			100,
+			100,
+			ScreenWidth,
+			ScreenHeight,
+			0
+		);
+
+		if (!mWindow) {
+			SDL_Log("Unable to create window: %s", SDL_GetError());
+			return false;
+		}
 
-	mRenderer = SDL_CreateRenderer(
-		mWindow,
-		-1,
-		SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC
-	);
+		mRenderer = SDL_CreateRenderer(
+			mWindow,
+			-1,
+			SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC
+		);
+	}
 
 	if (!mRenderer) {
 		SDL_Log("Unable to create renderer: %s", SDL_GetError());
 		return false;
 	}
 
+	mTextures.SetRenderer(mRenderer);
+	mSpriteBatch.SetRenderer(mRenderer);
+
 	if (IMG_Init(IMG_INIT_PNG) == 0) {
 		SDL_Log("Unable to initialise SDL_image: %s", SDL_GetError());
 		return false;
 	}
 
+	// Pre-decoded textures, if the bundle has been built (see --bundle)
+	mTextures.MountBundle(BundleFile);
+
+	// Decode threads for async texture loads
+	mTextures.StartLoader();
+	// Worker threads for actor updates
+	mJobs.Start(mNumThreads);
+
 	LoadData();
 
-	mTicksCount = SDL_GetTicks();
+	mPacer.Reset();
 
 	return true;
 }
 
 void Game::RunLoop() {
 	while (mIsRunning) {
+		PROFILE_SCOPE("Frame");
+		ProcessInput();
+		if (!mIsRunning) {
+			break;
+		}
+		UpdateGame();
+		GenerateOutput();
+	}
+}
+
+void Game::RunFrames(int numFrames) {
+	for (int i = 0; i < numFrames && mIsRunning; i++) {
+		PROFILE_SCOPE("Frame");
 		ProcessInput();
+		if (!mIsRunning) {
+			break;
+		}
 		UpdateGame();
 		GenerateOutput();
 	}
 }
 
 void Game::ProcessInput() {
+	PROFILE_SCOPE("ProcessInput");
 	SDL_Event event;
 
+	// A replay ends with its log
+	if (mInputLog.IsReplaying() && !mInputLog.NextFrame()) {
+		mIsRunning = false;
+		return;
+	}
+
 	// While there are still events in the que
 	while (SDL_PollEvent(&event)) {
 		switch (event.type) {
@@ -79,7 +163,20 @@ void Game::ProcessInput() {
 	}
 
 	// Get state of keyboard
-	const Uint8* state = SDL_GetKeyboardState(NULL);
+	// (Headless runs have no keyboard, so every key reads as released,
+	// unless they're replaying one)
+	static const Uint8 noKeys[SDL_NUM_SCANCODES] = {};
+	const Uint8* state;
+	if (mInputLog.IsReplaying()) {
+		state = mInputLog.GetKeys();
+	}
+	else {
+		state = mHeadless ? noKeys : SDL_GetKeyboardState(NULL);
+	}
+
+	if (mInputLog.IsRecording()) {
+		mInputLog.RecordKeys(state);
+	}
 
 	if (state[SDL_SCANCODE_ESCAPE]) {
 		mIsRunning = false;
@@ -89,60 +186,271 @@ void Game::ProcessInput() {
 }
 
 void Game::UpdateGame() {
-	// Compute delta time
-	// Wait until 16ms has elapsed since last frame
-	while (!SDL_TICKS_PASSED(SDL_GetTicks(), mTicksCount + 16))
-		;
+	float deltaTime;
 
-	float deltaTime = (SDL_GetTicks() - mTicksCount) / 1000.0f;
+	if (mInputLog.IsReplaying()) {
+		// Same frame times as the recording, so the same steps run
+		deltaTime = mInputLog.GetDeltaTime();
+	}
+	else if (mFixedDeltaTime > 0.0f) {
+		// Fixed step, don't wait on the clock so runs are reproducible
+		// and go as fast as the CPU allows
+		deltaTime = mFixedDeltaTime;
+	}
+	else {
+		// Compute delta time
+		// Sleep until the next frame is due
+		deltaTime = mPacer.WaitForNextFrame();
+
+		// A long stall (debugger, window drag) shouldn't turn into a burst of steps
+		if (deltaTime > MaxFrameTime) {
+			mDroppedTime += deltaTime - MaxFrameTime;
+			deltaTime = MaxFrameTime;
+		}
+	}
+	mFrameCount++;
+
+	PROFILE_SCOPE("UpdateGame");
+
+	// Last frame's scratch allocations are done with
+	mFrameArena.Reset();
+
+	// Upload any textures the loader threads have finished decoding
+	{
+		PROFILE_SCOPE("ProcessUploads");
+		mTextures.ProcessUploads();
+	}
+
+	// Run as many fixed steps as the frame's time covers, so the simulation
+	// behaves the same whatever the frame rate. What's left over (less than a
+	// step) carries into the next frame and sets how far to interpolate.
+	mAccumulator += deltaTime;
+	int steps = 0;
+	while (mAccumulator >= mSimStep && steps < mMaxSubSteps) {
+		StepSimulation(mSimStep);
+		mAccumulator -= mSimStep;
+		steps++;
+		mStepCount++;
+	}
 
-	if (deltaTime > 0.05f) {
-		deltaTime = 0.05f;
+	if (mAccumulator >= mSimStep) {
+		// Still behind: skip drawing for a frame or two to catch up, then give
+		// up on the backlog rather than falling further behind every frame
+		if (mSkippedInARow < MaxSkippedRenders) {
+			mSkipRender = true;
+			mSkippedInARow++;
+		}
+		else {
+			double backlog = std::floor(mAccumulator / mSimStep) * mSimStep;
+			mDroppedTime += backlog;
+			mAccumulator -= backlog;
+			mSkipRender = false;
+			mSkippedInARow = 0;
+		}
+	}
+	else {
+		mSkipRender = false;
+		mSkippedInARow = 0;
 	}
-	
-	// Update tick count (for next frame)
-	mTicksCount = SDL_GetTicks();
+
+	mInterpolation = static_cast<float>(Math::Min(mAccumulator / mSimStep, 1.0));
+
+	if (mInputLog.IsRecording()) {
+		mInputLog.RecordFrame(deltaTime, ComputeStateHash());
+	}
+	else if (mInputLog.IsReplaying()) {
+		mInputLog.CheckHash(ComputeStateHash());
+	}
+}
+
+uint64_t Game::ComputeStateHash() const {
+	PROFILE_SCOPE("ComputeStateHash");
+	uint64_t hash = InputLog::HashSeed;
+	hash = InputLog::Hash(hash, &mStepCount, sizeof(mStepCount));
+	for (auto actor : mActors) {
+		if (!actor) {
+			continue;
+		}
+		const Vector2& pos = actor->GetPosition();
+		hash = InputLog::Hash(hash, pos.x);
+		hash = InputLog::Hash(hash, pos.y);
+		hash = InputLog::Hash(hash, actor->GetRotation());
+		hash = InputLog::Hash(hash, actor->GetScale());
+		Actor::State state = actor->GetState();
+		hash = InputLog::Hash(hash, &state, sizeof(state));
+	}
+	return mWorld.HashState(hash);
+}
+
+void Game::StepSimulation(float deltaTime) {
+	PROFILE_SCOPE("StepSimulation");
 
 	// Update all actors
+	// Actors that only touch themselves are spread over the job threads,
+	// then the rest run one at a time on this thread
+	// (Actors deleted mid-update leave a nullptr behind until the sweep)
 	mUpdatingActors = true;
-	for (auto actor : mActors) {
-		actor->Update(deltaTime);
+	{
+		PROFILE_SCOPE("UpdateActors");
+
+		mParallelUpdate = true;
+		mJobs.ParallelFor(static_cast<int>(mActors.size()), ActorsPerJob, [this, deltaTime](int begin, int end) {
+			for (int i = begin; i < end; i++) {
+				Actor* actor = mActors[i];
+				if (actor && actor->GetUpdateAccess() == Actor::EAccessSelf) {
+					actor->Update(deltaTime);
+				}
+			}
+		});
+		mParallelUpdate = false;
+
+		for (auto actor : mActors) {
+			if (actor && actor->GetUpdateAccess() == Actor::EAccessShared) {
+				actor->Update(deltaTime);
+			}
+		}
 	}
 	mUpdatingActors = false;
 
+	// Run the entity systems over the pools
+	{
+		PROFILE_SCOPE("EntityWorld::Update");
+		mWorld.Update(deltaTime);
+	}
+
+	// Catch the grid up with everything that moved
+	{
+		PROFILE_SCOPE("SpatialGrid::UpdateAll");
+		mGrid.UpdateAll();
+	}
+
 	// Move the actors from mPendingActors to mActors
-	for (auto pending : mPendingActors) {
-		mActors.emplace_back(pending);
+	{
+		PROFILE_SCOPE("MergePending");
+		for (auto pending : mPendingActors) {
+			pending->mSlot = static_cast<int>(mActors.size());
+			pending->mSlotPending = false;
+			mActors.emplace_back(pending);
+		}
+		mPendingActors.clear();
 	}
-	mPendingActors.clear();
 
-	// Add any dead actors to a temp vector
-	std::vector<Actor*> deadActors;
+	PROFILE_SCOPE("SweepDead");
+
+	// Compact mActors in one pass, pulling dead actors out into a temp vector
+	// (Keeps the order of the survivors, and deleting is then O(1) per actor)
+	std::vector<Actor*, ArenaAllocator<Actor*>> deadActors{ ArenaAllocator<Actor*>(&mFrameArena) };
+	size_t live = 0;
 	for (auto actor : mActors) {
+		if (!actor) {
+			continue;
+		}
+
 		if (actor->GetState() == Actor::EDead) {
+			actor->mSlot = -1;
 			deadActors.emplace_back(actor);
 		}
+		else {
+			actor->mSlot = static_cast<int>(live);
+			mActors[live++] = actor;
+		}
 	}
+	mActors.resize(live);
 
-	// Delete dead actors (which removes them from mActors)
+	// Delete dead actors (already out of mActors)
 	for (auto actor : deadActors) {
 		delete actor;
 	}
 }
 
 void Game::GenerateOutput() {
+	if (mHeadless && !mHeadlessRendering) {
+		return;
+	}
+
+	// Catching up on simulation steps
+	if (mSkipRender) {
+		mSkippedRenders++;
+		return;
+	}
+
+	PROFILE_SCOPE("GenerateOutput");
+
+	FlushTransforms();
+
 	SDL_SetRenderDrawColor(mRenderer, 0, 0, 0, 255);
 	SDL_RenderClear(mRenderer);
 
-	// Draw all sprite components
-	for (auto sprite : mSprites) {
-		sprite->Draw(mRenderer);
+	// Draw all sprite components, a layer at a time
+	// (Entity sprites are slotted in between by draw order)
+	{
+		PROFILE_SCOPE("DrawSprites");
+		mDrawList.Sort();
+		mSpriteBatch.Begin();
+		mCamera.BeginFrame();
+		mWorld.BeginDraw(mInterpolation, &mCamera);
+		for (const auto& layer : mDrawList.GetLayers()) {
+			mWorld.DrawUpTo(&mSpriteBatch, layer.first);
+			for (auto sprite : layer.second.mSprites) {
+				// Off screen sprites never reach the batch
+				if (sprite->Cull(&mCamera)) {
+					continue;
+				}
+				sprite->Draw(&mSpriteBatch);
+			}
+		}
+		mWorld.EndDraw(&mSpriteBatch);
+		mSpriteBatch.End();
 	}
 
+	PROFILE_SCOPE("RenderPresent");
 	SDL_RenderPresent(mRenderer);
 }
 
+void Game::FlushTransforms() {
+	PROFILE_SCOPE("FlushTransforms");
+
+	// Actors that haven't moved only cost the flag check
+	for (auto actor : mActors) {
+		if (actor->ComputeWorldTransform()) {
+			mTransformsRecomputed++;
+		}
+	}
+	for (auto actor : mPendingActors) {
+		if (actor->ComputeWorldTransform()) {
+			mTransformsRecomputed++;
+		}
+	}
+	mTransformsChecked += mActors.size() + mPendingActors.size();
+}
+
 void Game::LoadData() {
+	// Pack the animation frames onto atlas pages so animating only
+	// moves the source rect instead of switching textures
+	mTextures.BuildAtlas({
+		"Assets/Ship01.png",
+		"Assets/Ship02.png",
+		"Assets/Ship03.png",
+		"Assets/Ship04.png",
+		"Assets/Skeleton/Character01.png",
+		"Assets/Skeleton/Character02.png",
+		"Assets/Skeleton/Character03.png",
+		"Assets/Skeleton/Character04.png",
+		"Assets/Skeleton/Character05.png",
+		"Assets/Skeleton/Character06.png",
+		"Assets/Skeleton/Character07.png",
+		"Assets/Skeleton/Character08.png",
+		"Assets/Skeleton/Character09.png",
+		"Assets/Skeleton/Character10.png",
+		"Assets/Skeleton/Character11.png",
+		"Assets/Skeleton/Character12.png",
+		"Assets/Skeleton/Character13.png",
+		"Assets/Skeleton/Character14.png",
+		"Assets/Skeleton/Character15.png",
+	});
+
+	// Everything else is requested asynchronously, components take the handles
+	// straight away and start drawing once the upload has happened
 	// Create the player's ship
 	mShip = new Ship(this);
 	mShip->SetPosition(Vector2{ 100.0f, 384.0f });
@@ -152,44 +460,40 @@ void Game::LoadData() {
 	// (This doesn't need a subclass)
 	Actor* temp = new Actor(this);
 	temp->SetPosition(Vector2{ 512.0f, 284.0f });
+	temp->SetUpdateAccess(Actor::EAccessSelf);
 
-	BGSpriteComponent* bg = new BGSpriteComponent(temp);
-	bg->SetScreenSize(Vector2{ 1024.0f, 768.0f });
-	std::vector<SDL_Texture*> bgtexs = {
-		GetTexture("Assets/Stars.png"),
-		GetTexture("Assets/Stars.png")
-	};
-
-	bg->SetBGTextures(bgtexs);
-	bg->SetScrollSpeed(-200.0f);
+	// Star field scrolling behind everything else
+	ParallaxComponent* bg = new ParallaxComponent(temp);
+	bg->AddLayer(GetTextureAsync("Assets/Stars.png"), -200.0f);
 
 	// Create skeleton
 	Actor* skele = new Actor(this);
 	skele->SetPosition(Vector2{ 400.0f, 184.0f });
 	skele->SetScale(1.5f);
+	skele->SetUpdateAccess(Actor::EAccessSelf);
 
 	AnimSpriteComponent* asc = new AnimSpriteComponent(skele);
-	std::vector<SDL_Texture*> skeleWalk = {
-		GetTexture("Assets/Skeleton/Character01.png"),
-		GetTexture("Assets/Skeleton/Character02.png"),
-		GetTexture("Assets/Skeleton/Character03.png"),
-		GetTexture("Assets/Skeleton/Character04.png"),
-		GetTexture("Assets/Skeleton/Character05.png"),
-		GetTexture("Assets/Skeleton/Character06.png"),
+	std::vector<TextureHandle> skeleWalk = {
+		GetTextureAsync("Assets/Skeleton/Character01.png"),
+		GetTextureAsync("Assets/Skeleton/Character02.png"),
+		GetTextureAsync("Assets/Skeleton/Character03.png"),
+		GetTextureAsync("Assets/Skeleton/Character04.png"),
+		GetTextureAsync("Assets/Skeleton/Character05.png"),
+		GetTextureAsync("Assets/Skeleton/Character06.png"),
 	};
 
 	asc->SetAnimTextures(skeleWalk, "Skeleton Walk");
 
-	std::vector<SDL_Texture*> skeleJump = {
-		GetTexture("Assets/Skeleton/Character07.png"),
-		GetTexture("Assets/Skeleton/Character08.png"),
-		GetTexture("Assets/Skeleton/Character09.png"),
-		GetTexture("Assets/Skeleton/Character10.png"),
-		GetTexture("Assets/Skeleton/Character11.png"),
-		GetTexture("Assets/Skeleton/Character12.png"),
-		GetTexture("Assets/Skeleton/Character13.png"),
-		GetTexture("Assets/Skeleton/Character14.png"),
-		GetTexture("Assets/Skeleton/Character15.png"),
+	std::vector<TextureHandle> skeleJump = {
+		GetTextureAsync("Assets/Skeleton/Character07.png"),
+		GetTextureAsync("Assets/Skeleton/Character08.png"),
+		GetTextureAsync("Assets/Skeleton/Character09.png"),
+		GetTextureAsync("Assets/Skeleton/Character10.png"),
+		GetTextureAsync("Assets/Skeleton/Character11.png"),
+		GetTextureAsync("Assets/Skeleton/Character12.png"),
+		GetTextureAsync("Assets/Skeleton/Character13.png"),
+		GetTextureAsync("Assets/Skeleton/Character14.png"),
+		GetTextureAsync("Assets/Skeleton/Character15.png"),
 	};
 
 	asc->SetAnimTextures(skeleJump, "Skeleton Jump");
@@ -202,97 +506,136 @@ void Game::UnloadData() {
 		delete mActors.back();
 	}
 
+	// Entities not owned by an actor
+	mWorld.Clear();
+
+	// Clips hold texture handles, drop them first
+	mAnimations.Clear();
+
 	// Destroy textures
-	for (auto i : mTextures) {
-		SDL_DestroyTexture(i.second);
-	}
-	mTextures.clear();
+	mTextures.Clear();
 }
 
-SDL_Texture* Game::GetTexture(const std::string& fileName) {
-	SDL_Texture* tex = nullptr;
-
-	// Is the texture already in the map?
-	auto iter = mTextures.find(fileName);
+bool Game::StartRecording(const std::string& fileName) {
+	return mInputLog.StartRecording(fileName, mSimStep);
+}
 
-	if (iter != mTextures.end()) {
-		tex = iter->second;
+bool Game::StartReplay(const std::string& fileName) {
+	if (!mInputLog.StartReplay(fileName)) {
+		return false;
 	}
-	else {
-		// Load from file
-		SDL_Surface* surf = IMG_Load(fileName.c_str());
-
-		if (!surf) {
-			SDL_Log("Failed to loadtexture file: %s", fileName.c_str());
-			return nullptr;
-		}
-
-		// Create texture from surface
-		tex = SDL_CreateTextureFromSurface(mRenderer, surf);
-		SDL_FreeSurface(surf);
+	// Steps have to be the same size as the recording's for the states to match
+	mSimStep = mInputLog.GetSimStep();
+	return true;
+}
 
-		if (!tex) {
-			SDL_Log("Failed to convert surface to texture for: %s", fileName.c_str());
-			return nullptr;
-		}
-	}
+TextureHandle Game::GetTexture(const std::string& fileName) {
+	return mTextures.Load(fileName);
+}
 
-	return tex;
+TextureHandle Game::GetTextureAsync(const std::string& fileName) {
+	return mTextures.LoadAsync(fileName);
 }
 
 void Game::Shutdown() {
+	mPacer.LogStats();
+	mTextures.StopLoader();
+	mTextures.LogStats();
+	mSpriteBatch.LogStats(mFrameCount - mSkippedRenders);
+	mCamera.LogStats(mFrameCount - mSkippedRenders);
+	mInputLog.LogStats();
+	mInputLog.Close();
+	if (mFrameCount > 0) {
+		SDL_Log("Simulation: %d steps of %.2f ms over %d frames (%.2f per frame), %d renders skipped, %.3f s dropped",
+			mStepCount,
+			mSimStep * 1000.0f,
+			mFrameCount,
+			static_cast<double>(mStepCount) / mFrameCount,
+			mSkippedRenders,
+			mDroppedTime
+		);
+	}
+	if (mTransformsChecked > 0) {
+		SDL_Log("Transforms: %lld of %lld recomputed (%.1f%%)",
+			mTransformsRecomputed,
+			mTransformsChecked,
+			100.0 * mTransformsRecomputed / mTransformsChecked
+		);
+	}
+	mJobs.Shutdown();
 	UnloadData();
+	ObjectPool::LogStats();
+	mFrameArena.LogStats();
 	IMG_Quit();
-	SDL_DestroyWindow(mWindow);
 	SDL_DestroyRenderer(mRenderer);
+	SDL_DestroyWindow(mWindow);
+	SDL_FreeSurface(mHeadlessSurface);
 	SDL_Quit();
 }
 
 void Game::AddActor(Actor* actor) {
-	// If updating actors, add to pending actors
-	if (mUpdatingActors) {
-		mPendingActors.emplace_back(actor);
-	}
-	else {
-		mActors.emplace_back(actor);
+	// Job threads can spawn actors during the parallel update
+	std::unique_lock<std::mutex> lock(mStructureMutex, std::defer_lock);
+	if (mParallelUpdate) {
+		lock.lock();
 	}
+
+	// If updating actors, add to pending actors
+	std::vector<Actor*>& actors = mUpdatingActors ? mPendingActors : mActors;
+
+	// Actor remembers its slot so removing it doesn't need a search
+	actor->mSlot = static_cast<int>(actors.size());
+	actor->mSlotPending = mUpdatingActors;
+	actors.emplace_back(actor);
 }
 
 void Game::RemoveActor(Actor* actor) {
-	// If updating actors, remove from pending actors
-	if (mUpdatingActors) {
-		auto it = std::find(mPendingActors.begin(), mPendingActors.end(), actor);
-		int index = it - mPendingActors.begin();
-		mPendingActors.erase(mPendingActors.begin() + index);
+	std::unique_lock<std::mutex> lock(mStructureMutex, std::defer_lock);
+	if (mParallelUpdate) {
+		lock.lock();
+	}
+
+	mGrid.Remove(actor);
+
+	// Already swept out (dead actors are removed before they're deleted)
+	if (actor->mSlot < 0) {
+		return;
+	}
+
+	std::vector<Actor*>& actors = actor->mSlotPending ? mPendingActors : mActors;
+	int slot = actor->mSlot;
+
+	if (mUpdatingActors && !actor->mSlotPending) {
+		// mActors is being iterated, leave a hole for the sweep to compact
+		actors[slot] = nullptr;
 	}
 	else {
-		auto it = std::find(mActors.begin(), mActors.end(), actor);
-		int index = it - mActors.begin();
-		mActors.erase(mActors.begin() + index);
+		// Swap with the last actor and pop, O(1)
+		Actor* last = actors.back();
+		actors[slot] = last;
+		last->mSlot = slot;
+		actors.pop_back();
 	}
+
+	actor->mSlot = -1;
 }
 
 void Game::AddSprite(SpriteComponent* sprite) {
-	// Find the insertion point in the vector
-	// ( The first element with a higher sort order than sprite )
-	int myDrawOrder = sprite->GetDrawOrder();
-	auto iter = mSprites.begin();
-
-	for (;
-		iter != mSprites.end();
-		++iter)
-	{
-		if (myDrawOrder < (*iter)->GetDrawOrder()) {
-			break;
-		}
+	// Nothing reads the draw list during update, so spawns from
+	// job threads only need to take turns
+	std::unique_lock<std::mutex> lock(mStructureMutex, std::defer_lock);
+	if (mParallelUpdate) {
+		lock.lock();
 	}
 
-	// Insert element before position of iterator
-	mSprites.insert(iter, sprite);
+	mDrawList.Add(sprite);
 }
 
 void Game::RemoveSprite(SpriteComponent* sprite) {
-	// (We can't swap because it ruins ordering)
-	auto iter = std::find(mSprites.begin(), mSprites.end(), sprite);
-	mSprites.erase(iter);
+	std::unique_lock<std::mutex> lock(mStructureMutex, std::defer_lock);
+	if (mParallelUpdate) {
+		lock.lock();
+	}
+
+	mDrawList.Remove(sprite);
 }
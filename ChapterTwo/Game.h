@@ -1,6 +1,17 @@
 #pragma once
 #include "SDL.h"
-#include <unordered_map>
+#include "FramePacer.h"
+#include "TextureCache.h"
+#include "SpriteBatch.h"
+#include "EntityWorld.h"
+#include "DrawList.h"
+#include "JobSystem.h"
+#include "FrameArena.h"
+#include "SpatialGrid.h"
+#include "AnimationRegistry.h"
+#include "Camera.h"
+#include "InputLog.h"
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -10,13 +21,71 @@ public:
 	Game();
 	bool Initialise();
 	void RunLoop();
+	// Runs a set number of frames back to back (used by headless runs)
+	void RunFrames(int numFrames);
 	void Shutdown();
 
+	// Headless mode skips the window and renders (if at all) into an offscreen surface
+	// Must be set before Initialise
+	void SetHeadless(bool headless) { mHeadless = headless; };
+	void SetHeadlessRendering(bool render) { mHeadlessRendering = render; };
+	bool IsHeadless() const { return mHeadless; };
+	// Fixed delta time fed to UpdateGame instead of the clock (0.0f uses the clock)
+	void SetFixedDeltaTime(float deltaTime) { mFixedDeltaTime = deltaTime; };
+	// Simulation runs in fixed steps at this rate whatever the frame rate
+	// (several steps in a slow frame, none in a fast one)
+	void SetSimRate(float hz) { mSimStep = 1.0f / hz; };
+	float GetSimStep() const { return mSimStep; };
+	// Most steps run in one frame before it starts skipping renders / dropping time
+	void SetMaxSubSteps(int steps) { mMaxSubSteps = steps; };
+	// How far between the last two steps the current frame is drawn (0 to 1)
+	float GetInterpolation() const { return mInterpolation; };
+	int GetStepCount() const { return mStepCount; };
+	float GetFixedDeltaTime() const { return mFixedDeltaTime; };
+	// Frame rate limit when running on the clock (0.0f for uncapped)
+	void SetTargetFPS(float fps) { mPacer.SetTargetFPS(fps); };
+	int GetFrameCount() const { return mFrameCount; };
+	// Threads used for actor updates, including the main thread
+	// (0 picks one per core), must be set before Initialise
+	void SetNumThreads(int numThreads) { mNumThreads = numThreads; };
+	JobSystem* GetJobs() { return &mJobs; };
+	// Record the keyboard and frame times of this run to a log, or play one
+	// back instead of reading the keyboard and clock (a replay stops when its
+	// log runs out). Must be called before Initialise, after SetSimRate.
+	bool StartRecording(const std::string& fileName);
+	bool StartReplay(const std::string& fileName);
+	InputLog* GetInputLog() { return &mInputLog; };
+	// Hash of the simulation's state (actors and entities), checked against
+	// the recording every frame of a replay
+	uint64_t ComputeStateHash() const;
+	// Scratch memory that's thrown away at the start of every frame
+	FrameArena* GetFrameArena() { return &mFrameArena; };
+
+	// Screen dimensions
+	static const int ScreenWidth = 1024;
+	static const int ScreenHeight = 768;
+
+	// Asset bundle mounted at startup when it exists
+	static constexpr const char* BundleFile = "Assets.bundle";
+
 	void AddActor(class Actor* actor);
 	void RemoveActor(class Actor* actor);
 
-	// Load Texture
-	SDL_Texture* GetTexture(const std::string& fileName);
+	// Load Texture (cached, shared between callers)
+	TextureHandle GetTexture(const std::string& fileName);
+	// Decoded on a loader thread, the handle fills in once uploaded
+	TextureHandle GetTextureAsync(const std::string& fileName);
+	TextureCache* GetTextureCache() { return &mTextures; };
+	// Animation clips shared by every animated sprite
+	AnimationRegistry* GetAnimations() { return &mAnimations; };
+
+	// Data-oriented storage for hot entity data
+	EntityWorld* GetWorld() { return &mWorld; };
+	// Broad phase for collision and area queries, actors opt in with Add
+	// (Refreshed after every actor has updated)
+	SpatialGrid* GetGrid() { return &mGrid; };
+	// What part of the world is on screen (sprites outside it are culled)
+	Camera* GetCamera() { return &mCamera; };
 
 	void AddSprite(class SpriteComponent* sprite);
 	void RemoveSprite(class SpriteComponent* sprite);
@@ -24,29 +93,92 @@ public:
 private:
 	void ProcessInput();
 	void UpdateGame();
+	// One fixed step of actors, entities and the grid
+	void StepSimulation(float deltaTime);
+	// Recompute the cached transforms of actors that moved (once per drawn frame)
+	void FlushTransforms();
 	void GenerateOutput();
 	void LoadData();
 	void UnloadData();
 
-	// Maps of textures loaded
-	std::unordered_map<std::string, SDL_Texture*> mTextures;
+	// Textures loaded
+	TextureCache mTextures;
+	// Animation clips, interned by name
+	AnimationRegistry mAnimations;
 
 	// Active actors
 	std::vector<class Actor*> mActors;
 	// Actors that are added whilst iterating through mActors
 	std::vector<class Actor*> mPendingActors;
-	// Sprites
-	std::vector<class SpriteComponent*> mSprites;
+	// Sprites, bucketed by draw order
+	DrawList mDrawList;
+
+	// Pooled entities (and actors bound to them)
+	EntityWorld mWorld;
+	// Actors tracked for collision
+	SpatialGrid mGrid;
+
+	// Batches sprite draws by texture
+	SpriteBatch mSpriteBatch;
+	// View into the world, culls sprites before they reach the batch
+	Camera mCamera;
+
+	// Per-frame scratch memory (reset at the top of UpdateGame)
+	FrameArena mFrameArena;
 
 	// Window created by SDL
 	SDL_Window* mWindow;
 	SDL_Renderer* mRenderer;
-	Uint32 mTicksCount;
+	// Offscreen surface the renderer draws to in headless mode
+	SDL_Surface* mHeadlessSurface;
+	// Limits the frame rate and measures delta time
+	FramePacer mPacer;
 	// Game should continue to run
 	bool mIsRunning;
 	// Are the actors being updated
 	bool mUpdatingActors;
 
+	// Runs EAccessSelf actors in parallel
+	JobSystem mJobs;
+	// Actors handed to a job thread at a time
+	static const int ActorsPerJob = 256;
+	int mNumThreads;
+	// Set while job threads are updating actors, actor/sprite
+	// adds and removes then go through mStructureMutex
+	bool mParallelUpdate;
+	std::mutex mStructureMutex;
+
+	// Headless/deterministic stepping
+	bool mHeadless;
+	bool mHeadlessRendering;
+	float mFixedDeltaTime;
+	int mFrameCount;
+
+	// Fixed step simulation
+	// Longest frame time the accumulator takes in (anything more is dropped)
+	static constexpr float MaxFrameTime = 0.25f;
+	// Renders skipped in a row while behind before the backlog is dropped
+	static const int MaxSkippedRenders = 2;
+	float mSimStep;
+	int mMaxSubSteps;
+	// Frame time not yet simulated
+	double mAccumulator;
+	float mInterpolation;
+	// Behind on steps, don't draw this frame
+	bool mSkipRender;
+	int mSkippedInARow;
+	int mStepCount;
+	int mSkippedRenders;
+	// Time thrown away by the caps (seconds)
+	double mDroppedTime;
+
+	// Keyboard and frame time log being recorded or replayed
+	InputLog mInputLog;
+
+	// Cached transform stats (recomputed vs checked, summed over drawn frames)
+	long long mTransformsRecomputed;
+	long long mTransformsChecked;
+
 	// Game specific
 	class Ship* mShip; // Player's ship
 };
\ No newline at end of file
@@ -0,0 +1,202 @@
+#include "InputLog.h"
+#include <cstring>
+
+namespace
+{
+	const char LogMagic[4] = { 'G', 'P', 'I', 'L' };
+}
+
+InputLog::InputLog()
+	: mKeys{}
+	, mDeltaTime(0.0f)
+	, mSimStep(0.0f)
+	, mFile(nullptr)
+	, mNumChanges(0)
+	, mBytesWritten(0)
+	, mCursor(0)
+	, mExpectedHash(0)
+	, mMismatches(0)
+	, mNumFrames(0)
+	, mFrame(0)
+{}
+
+InputLog::~InputLog() {
+	Close();
+}
+
+bool InputLog::StartRecording(const std::string& fileName, float simStep) {
+	Close();
+
+	mFile = fopen(fileName.c_str(), "wb");
+	if (!mFile) {
+		SDL_Log("Failed to open input log for writing: %s", fileName.c_str());
+		return false;
+	}
+	mFileName = fileName;
+	mSimStep = simStep;
+
+	// The frame count is filled in by Close
+	FileHeader header = {};
+	memcpy(header.mMagic, LogMagic, sizeof(LogMagic));
+	header.mVersion = Version;
+	header.mSimStep = simStep;
+	fwrite(&header, sizeof(header), 1, mFile);
+	mBytesWritten = sizeof(header);
+	return true;
+}
+
+bool InputLog::StartReplay(const std::string& fileName) {
+	Close();
+
+	if (!mReplay.Open(fileName)) {
+		SDL_Log("Failed to open input log: %s", fileName.c_str());
+		return false;
+	}
+
+	const FileHeader* header = reinterpret_cast<const FileHeader*>(mReplay.GetData());
+	if (mReplay.GetSize() < sizeof(FileHeader)
+		|| memcmp(header->mMagic, LogMagic, sizeof(LogMagic)) != 0
+		|| header->mVersion != Version
+		|| header->mSimStep <= 0.0f)
+	{
+		SDL_Log("Not a valid input log: %s", fileName.c_str());
+		Close();
+		return false;
+	}
+
+	mFileName = fileName;
+	mSimStep = header->mSimStep;
+	mNumFrames = static_cast<int>(header->mNumFrames);
+	mCursor = sizeof(FileHeader);
+	return true;
+}
+
+void InputLog::Close() {
+	if (mFile) {
+		FileHeader header = {};
+		memcpy(header.mMagic, LogMagic, sizeof(LogMagic));
+		header.mVersion = Version;
+		header.mSimStep = mSimStep;
+		header.mNumFrames = static_cast<uint32_t>(mNumFrames);
+		fseek(mFile, 0, SEEK_SET);
+		fwrite(&header, sizeof(header), 1, mFile);
+
+		if (ferror(mFile) != 0) {
+			SDL_Log("Failed to write input log: %s", mFileName.c_str());
+		}
+		fclose(mFile);
+		mFile = nullptr;
+	}
+	mReplay.Close();
+
+	memset(mKeys, 0, sizeof(mKeys));
+	mDeltaTime = 0.0f;
+	mNumChanges = 0;
+	mBytesWritten = 0;
+	mCursor = 0;
+	mExpectedHash = 0;
+	mMismatches = 0;
+	mNumFrames = 0;
+	mFrame = 0;
+}
+
+void InputLog::RecordKeys(const Uint8* state) {
+	mNumChanges = 0;
+	for (int i = 0; i < SDL_NUM_SCANCODES; i++) {
+		// SDL only ever reports 0 or 1
+		Uint8 down = state[i] ? 1 : 0;
+		if (down != mKeys[i]) {
+			mKeys[i] = down;
+			mChanges[mNumChanges++] = static_cast<uint16_t>(i);
+		}
+	}
+}
+
+void InputLog::RecordFrame(float deltaTime, uint64_t hash) {
+	FrameHeader frame = {};
+	frame.mDeltaTime = deltaTime;
+	frame.mNumChanges = mNumChanges;
+	frame.mHash = hash;
+	fwrite(&frame, sizeof(frame), 1, mFile);
+	fwrite(mChanges, sizeof(uint16_t), mNumChanges, mFile);
+
+	mBytesWritten += sizeof(frame) + mNumChanges * sizeof(uint16_t);
+	mNumChanges = 0;
+	mNumFrames++;
+}
+
+bool InputLog::NextFrame() {
+	const uint8_t* data = mReplay.GetData();
+	size_t size = mReplay.GetSize();
+
+	if (mFrame >= mNumFrames || mCursor + sizeof(FrameHeader) > size) {
+		return false;
+	}
+
+	// Frames are packed back to back, so they may not be aligned
+	FrameHeader frame;
+	memcpy(&frame, data + mCursor, sizeof(frame));
+	size_t changesSize = frame.mNumChanges * sizeof(uint16_t);
+	if (frame.mNumChanges > SDL_NUM_SCANCODES || mCursor + sizeof(frame) + changesSize > size) {
+		SDL_Log("Input log %s is truncated at frame %d", mFileName.c_str(), mFrame);
+		return false;
+	}
+	mCursor += sizeof(frame);
+
+	for (uint32_t i = 0; i < frame.mNumChanges; i++) {
+		uint16_t scancode;
+		memcpy(&scancode, data + mCursor, sizeof(scancode));
+		mCursor += sizeof(scancode);
+		if (scancode < SDL_NUM_SCANCODES) {
+			mKeys[scancode] ^= 1;
+		}
+	}
+
+	mDeltaTime = frame.mDeltaTime;
+	mExpectedHash = frame.mHash;
+	mFrame++;
+	return true;
+}
+
+bool InputLog::CheckHash(uint64_t hash) {
+	if (hash == mExpectedHash) {
+		return true;
+	}
+
+	if (mMismatches == 0) {
+		SDL_Log("Replay diverged at frame %d: state hash %016llx, recorded %016llx",
+			mFrame - 1,
+			static_cast<unsigned long long>(hash),
+			static_cast<unsigned long long>(mExpectedHash)
+		);
+	}
+	mMismatches++;
+	return false;
+}
+
+void InputLog::LogStats() const {
+	if (IsRecording()) {
+		SDL_Log("InputLog: recorded %d frames to %s (%.1f bytes per frame)",
+			mNumFrames,
+			mFileName.c_str(),
+			mNumFrames > 0 ? static_cast<double>(mBytesWritten) / mNumFrames : 0.0
+		);
+	}
+	else if (IsReplaying()) {
+		SDL_Log("InputLog: replayed %d of %d frames from %s, %d state hash mismatches",
+			mFrame,
+			mNumFrames,
+			mFileName.c_str(),
+			mMismatches
+		);
+	}
+}
+
+uint64_t InputLog::Hash(uint64_t hash, const void* data, size_t size) {
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include "SDL.h"
+#include "MappedFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// Records the keyboard and the frame time every frame so a session can be
+// replayed headlessly, frame for frame. Each frame also carries a hash of
+// the game state after it updated, so a replay can check the build being
+// run still simulates the same thing.
+//
+// Layout (little endian):
+//   FileHeader
+//   per frame: FrameHeader then mNumChanges uint16_t scancodes
+//   (keys that changed since the last frame, so held keys cost nothing)
+class InputLog
+{
+public:
+	InputLog();
+	~InputLog();
+
+	InputLog(const InputLog&) = delete;
+	InputLog& operator=(const InputLog&) = delete;
+
+	// Start writing a log (the sim step is stored so the replay matches)
+	bool StartRecording(const std::string& fileName, float simStep);
+	// Map a log for replay (false if it's missing or not a log)
+	bool StartReplay(const std::string& fileName);
+	// Finish the log being written or replayed
+	void Close();
+
+	bool IsRecording() const { return mFile != nullptr; };
+	bool IsReplaying() const { return mReplay.IsOpen(); };
+
+	// Recording: keyboard as read this frame, then the frame's time and
+	// the state hash after it updated
+	void RecordKeys(const Uint8* state);
+	void RecordFrame(float deltaTime, uint64_t hash);
+
+	// Replay: move on to the next frame (false once the log runs out)
+	bool NextFrame();
+	const Uint8* GetKeys() const { return mKeys; };
+	float GetDeltaTime() const { return mDeltaTime; };
+	float GetSimStep() const { return mSimStep; };
+	int GetNumFrames() const { return mNumFrames; };
+	// Compare the replayed frame's state with the recording
+	// (the first mismatch is logged, later ones only counted)
+	bool CheckHash(uint64_t hash);
+	int GetMismatches() const { return mMismatches; };
+
+	void LogStats() const;
+
+	// FNV-1a over raw bytes, chained through hash
+	static constexpr uint64_t HashSeed = 14695981039346656037ull;
+	static uint64_t Hash(uint64_t hash, const void* data, size_t size);
+	static uint64_t Hash(uint64_t hash, float value) { return Hash(hash, &value, sizeof(value)); };
+
+private:
+	static const uint32_t Version = 1;
+
+	struct FileHeader {
+		char mMagic[4];
+		uint32_t mVersion;
+		float mSimStep;
+		uint32_t mNumFrames;
+	};
+
+	struct FrameHeader {
+		float mDeltaTime;
+		uint32_t mNumChanges;
+		uint64_t mHash;
+	};
+
+	// Keyboard as of the current frame
+	Uint8 mKeys[SDL_NUM_SCANCODES];
+	float mDeltaTime;
+	float mSimStep;
+
+	// Recording
+	FILE* mFile;
+	std::string mFileName;
+	// Scancodes that changed this frame (written with the frame)
+	uint16_t mChanges[SDL_NUM_SCANCODES];
+	uint32_t mNumChanges;
+	size_t mBytesWritten;
+
+	// Replay
+	MappedFile mReplay;
+	size_t mCursor;
+	uint64_t mExpectedHash;
+	int mMismatches;
+
+	// Frames recorded, or in the log being replayed
+	int mNumFrames;
+	// Frames replayed so far
+	int mFrame;
+};
@@ -0,0 +1,171 @@
+#include "JobSystem.h"
+
+JobSystem::JobSystem()
+	: mRemaining(0)
+	, mGeneration(0)
+	, mQuit(false)
+	, mJobsRun(0)
+	, mJobsStolen(0)
+{
+	// Always at least the calling thread's queue
+	mQueues.emplace_back(new WorkQueue());
+}
+
+JobSystem::~JobSystem() {
+	Shutdown();
+}
+
+void JobSystem::Start(int numThreads) {
+	Shutdown();
+
+	if (numThreads <= 0) {
+		// Workers past 8 don't pay for themselves on actor updates
+		numThreads = static_cast<int>(std::thread::hardware_concurrency());
+		numThreads = numThreads > 8 ? 8 : numThreads;
+	}
+	if (numThreads < 1) {
+		numThreads = 1;
+	}
+
+	mQuit = false;
+	for (int i = 1; i < numThreads; i++) {
+		mQueues.emplace_back(new WorkQueue());
+	}
+	for (int i = 1; i < numThreads; i++) {
+		mThreads.emplace_back(&JobSystem::WorkerLoop, this, i);
+	}
+}
+
+void JobSystem::Shutdown() {
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+		mQuit = true;
+	}
+	mWake.notify_all();
+
+	for (auto& thread : mThreads) {
+		thread.join();
+	}
+	mThreads.clear();
+	mQueues.resize(1);
+}
+
+void JobSystem::ParallelFor(int count, int chunkSize, const std::function<void(int, int)>& body) {
+	if (count <= 0) {
+		return;
+	}
+
+	if (chunkSize < 1) {
+		chunkSize = 1;
+	}
+
+	// Not worth waking anyone up for
+	if (mThreads.empty() || count <= chunkSize) {
+		body(0, count);
+		return;
+	}
+
+	// Every queue starts with an equal run of neighbouring chunks,
+	// stealing evens things out if some chunks are slower than others
+	int numChunks = (count + chunkSize - 1) / chunkSize;
+	mRemaining = numChunks;
+
+	int numQueues = static_cast<int>(mQueues.size());
+	for (int q = 0; q < numQueues; q++) {
+		int first = numChunks * q / numQueues;
+		int last = numChunks * (q + 1) / numQueues;
+
+		std::lock_guard<std::mutex> lock(mQueues[q]->mMutex);
+		for (int chunk = first; chunk < last; chunk++) {
+			int begin = chunk * chunkSize;
+			int end = begin + chunkSize < count ? begin + chunkSize : count;
+			mQueues[q]->mJobs.emplace_back(Job{ &body, begin, end });
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+		mGeneration++;
+	}
+	mWake.notify_all();
+
+	// Help out until every chunk is done
+	while (mRemaining.load(std::memory_order_acquire) > 0) {
+		if (!RunOneJob(0)) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+JobSystem::Stats JobSystem::GetStats() const {
+	return Stats{ mJobsRun.load(), mJobsStolen.load() };
+}
+
+void JobSystem::WorkerLoop(int index) {
+	int seenGeneration = 0;
+
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mSleepMutex);
+			mWake.wait(lock, [this, seenGeneration] {
+				return mQuit || mGeneration != seenGeneration;
+			});
+
+			if (mQuit) {
+				return;
+			}
+			seenGeneration = mGeneration;
+		}
+
+		// Keep going until the current batch has been drained
+		while (mRemaining.load(std::memory_order_acquire) > 0) {
+			if (!RunOneJob(index)) {
+				std::this_thread::yield();
+			}
+		}
+	}
+}
+
+bool JobSystem::RunOneJob(int index) {
+	Job job;
+	bool found = false;
+	bool stolen = false;
+
+	// Own queue first (newest work, still warm in cache)
+	{
+		WorkQueue& own = *mQueues[index];
+		std::lock_guard<std::mutex> lock(own.mMutex);
+		if (!own.mJobs.empty()) {
+			job = own.mJobs.back();
+			own.mJobs.pop_back();
+			found = true;
+		}
+	}
+
+	// Then steal the oldest work from someone else
+	int numQueues = static_cast<int>(mQueues.size());
+	for (int i = 1; i < numQueues && !found; i++) {
+		WorkQueue& victim = *mQueues[(index + i) % numQueues];
+		std::lock_guard<std::mutex> lock(victim.mMutex);
+		if (!victim.mJobs.empty()) {
+			job = victim.mJobs.front();
+			victim.mJobs.pop_front();
+			found = true;
+			stolen = true;
+		}
+	}
+
+	if (!found) {
+		return false;
+	}
+
+	(*job.mBody)(job.mBegin, job.mEnd);
+
+	mJobsRun.fetch_add(1, std::memory_order_relaxed);
+	if (stolen) {
+		mJobsStolen.fetch_add(1, std::memory_order_relaxed);
+	}
+	mRemaining.fetch_sub(1, std::memory_order_acq_rel);
+
+	return true;
+}
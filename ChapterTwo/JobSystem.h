@@ -0,0 +1,67 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs data-parallel work across a set of worker threads.
+// Every thread (the caller included) owns a queue; it pops its own work from
+// the back and, once that runs dry, steals from the front of the others.
+class JobSystem
+{
+public:
+	JobSystem();
+	~JobSystem();
+
+	// numThreads includes the calling thread
+	// (0 picks one per core, 1 runs everything inline on the caller)
+	void Start(int numThreads = 0);
+	void Shutdown();
+	int GetNumThreads() const { return static_cast<int>(mQueues.size()); };
+
+	// Split [0, count) into chunks of chunkSize and run body(begin, end) on them.
+	// The calling thread helps out and this returns once every chunk has run.
+	void ParallelFor(int count, int chunkSize, const std::function<void(int, int)>& body);
+
+	struct Stats {
+		int mJobsRun;
+		int mJobsStolen;
+	};
+	Stats GetStats() const;
+
+private:
+	struct Job {
+		const std::function<void(int, int)>* mBody;
+		int mBegin;
+		int mEnd;
+	};
+
+	// Locked deque: the owner works on the back, thieves take from the front
+	struct WorkQueue {
+		std::mutex mMutex;
+		std::deque<Job> mJobs;
+	};
+
+	void WorkerLoop(int index);
+	// Run one job from our own queue or steal one, false if there was none
+	bool RunOneJob(int index);
+
+	std::vector<std::unique_ptr<WorkQueue>> mQueues;
+	std::vector<std::thread> mThreads;
+
+	// Jobs queued or running from the current ParallelFor
+	std::atomic<int> mRemaining;
+
+	std::mutex mSleepMutex;
+	std::condition_variable mWake;
+	// Bumped for each ParallelFor so sleeping workers know there's new work
+	int mGeneration;
+	bool mQuit;
+
+	std::atomic<int> mJobsRun;
+	std::atomic<int> mJobsStolen;
+};
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read only memory mapping of a whole file
+// (mmap on POSIX, a file mapping view on Windows)
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// Map the file (false if it's missing or empty)
+	bool Open(const std::string& fileName);
+	void Close();
+
+	bool IsOpen() const { return mData != nullptr; };
+	const uint8_t* GetData() const { return mData; };
+	size_t GetSize() const { return mSize; };
+
+private:
+	const uint8_t* mData;
+	size_t mSize;
+	// Platform mapping handle (Windows only)
+	void* mMapping;
+};
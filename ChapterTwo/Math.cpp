@@ -0,0 +1,354 @@
+#include "Math.h"
+#include "SDL.h"
+
+// x86 builds get SSE/AVX batch kernels, picked at runtime from what the CPU has
+// (GCC/Clang compile each kernel for its own instruction set, MSVC doesn't need telling)
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MATH_SIMD 1
+#if defined(__GNUC__) || defined(__clang__)
+#define MATH_TARGET(isa) __attribute__((target(isa)))
+#else
+#define MATH_TARGET(isa)
+#endif
+#else
+#define MATH_SIMD 0
+#endif
+
+const Vector2 Vector2::Zero{ 0.0f, 0.0f };
+const Vector2 Vector2::UnitX{ 1.0f, 0.0f };
+const Vector2 Vector2::UnitY{ 0.0f, 1.0f };
+
+const Vector3 Vector3::Zero{ 0.0f, 0.0f, 0.0f };
+const Vector3 Vector3::UnitX{ 1.0f, 0.0f, 0.0f };
+const Vector3 Vector3::UnitY{ 0.0f, 1.0f, 0.0f };
+const Vector3 Vector3::UnitZ{ 0.0f, 0.0f, 1.0f };
+
+const Matrix3 Matrix3::Identity{ {
+	{ 1.0f, 0.0f, 0.0f },
+	{ 0.0f, 1.0f, 0.0f },
+	{ 0.0f, 0.0f, 1.0f }
+} };
+
+namespace
+{
+	Math::SimdLevel sSimdLevel = Math::BestSimdLevel();
+
+	// Each kernel handles floats/points from begin to end, the SIMD ones stop
+	// before a tail that doesn't fill a register and return where they stopped
+	void TransformScalar(const Matrix3& mat, const Vector2* in, Vector2* out, int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			out[i] = Vector2::Transform(in[i], mat);
+		}
+	}
+
+	// pos/vel are the points as flat x, y, x, y... floats
+	void IntegrateScalar(float* pos, const float* vel, float deltaTime, int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			pos[i] = pos[i] + vel[i] * deltaTime;
+		}
+	}
+
+	void BoundsScalar(const float* centers, const float* halfExtents, float* mins, float* maxs, int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			// (centers may be mins or maxs, read before writing)
+			float c = centers[i];
+			float h = halfExtents[i];
+			mins[i] = c - h;
+			maxs[i] = c + h;
+		}
+	}
+
+	void SinCosScalar(const float* angles, float* sins, float* coss, int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			float angle = angles[i];
+			sins[i] = Math::FastSin(angle);
+			coss[i] = Math::FastCos(angle);
+		}
+	}
+
+#if MATH_SIMD
+	// Two points per register: x0 y0 x1 y1
+	MATH_TARGET("sse2")
+	int TransformSSE(const Matrix3& mat, const Vector2* in, Vector2* out, int end) {
+		const __m128 row0 = _mm_setr_ps(mat.mat[0][0], mat.mat[0][1], mat.mat[0][0], mat.mat[0][1]);
+		const __m128 row1 = _mm_setr_ps(mat.mat[1][0], mat.mat[1][1], mat.mat[1][0], mat.mat[1][1]);
+		const __m128 row2 = _mm_setr_ps(mat.mat[2][0], mat.mat[2][1], mat.mat[2][0], mat.mat[2][1]);
+
+		int i = 0;
+		for (; i + 2 <= end; i += 2) {
+			__m128 p = _mm_loadu_ps(&in[i].x);
+			__m128 xx = _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 0, 0));
+			__m128 yy = _mm_shuffle_ps(p, p, _MM_SHUFFLE(3, 3, 1, 1));
+			__m128 result = _mm_add_ps(_mm_add_ps(_mm_mul_ps(xx, row0), _mm_mul_ps(yy, row1)), row2);
+			_mm_storeu_ps(&out[i].x, result);
+		}
+		return i;
+	}
+
+	MATH_TARGET("sse2")
+	int IntegrateSSE(float* pos, const float* vel, float deltaTime, int end) {
+		const __m128 dt = _mm_set1_ps(deltaTime);
+
+		int i = 0;
+		for (; i + 4 <= end; i += 4) {
+			__m128 p = _mm_add_ps(_mm_loadu_ps(pos + i), _mm_mul_ps(_mm_loadu_ps(vel + i), dt));
+			_mm_storeu_ps(pos + i, p);
+		}
+		return i;
+	}
+
+	MATH_TARGET("sse2")
+	int BoundsSSE(const float* centers, const float* halfExtents, float* mins, float* maxs, int end) {
+		int i = 0;
+		for (; i + 4 <= end; i += 4) {
+			__m128 c = _mm_loadu_ps(centers + i);
+			__m128 h = _mm_loadu_ps(halfExtents + i);
+			_mm_storeu_ps(mins + i, _mm_sub_ps(c, h));
+			_mm_storeu_ps(maxs + i, _mm_add_ps(c, h));
+		}
+		return i;
+	}
+
+	// Same steps as Math::SinPoly
+	MATH_TARGET("sse2")
+	__m128 SinPolySSE(__m128 r) {
+		__m128 r2 = _mm_mul_ps(r, r);
+		__m128 p = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-2.5052108e-8f), r2), _mm_set1_ps(2.7557319e-6f));
+		p = _mm_add_ps(_mm_mul_ps(p, r2), _mm_set1_ps(-1.9841270e-4f));
+		p = _mm_add_ps(_mm_mul_ps(p, r2), _mm_set1_ps(8.3333333e-3f));
+		p = _mm_add_ps(_mm_mul_ps(p, r2), _mm_set1_ps(-1.6666667e-1f));
+		return _mm_add_ps(_mm_mul_ps(_mm_mul_ps(r, r2), p), r);
+	}
+
+	// Same steps as Math::FastSin/FastCos, k's parity goes straight into the sign bit
+	MATH_TARGET("sse2")
+	void SinCosSSE(__m128 angle, __m128& sin, __m128& cos) {
+		const __m128 invPi = _mm_set1_ps(1.0f / Math::Pi);
+		const __m128 piHi = _mm_set1_ps(3.140625f);
+		const __m128 piLo = _mm_set1_ps(0.00096765358979f);
+		const __m128 half = _mm_set1_ps(0.5f);
+
+		__m128i ki = _mm_cvtps_epi32(_mm_mul_ps(angle, invPi));
+		__m128 k = _mm_cvtepi32_ps(ki);
+		__m128 r = _mm_sub_ps(angle, _mm_mul_ps(k, piHi));
+		r = _mm_sub_ps(r, _mm_mul_ps(k, piLo));
+		sin = _mm_xor_ps(SinPolySSE(r), _mm_castsi128_ps(_mm_slli_epi32(ki, 31)));
+
+		ki = _mm_cvtps_epi32(_mm_sub_ps(_mm_mul_ps(angle, invPi), half));
+		__m128 j = _mm_add_ps(_mm_cvtepi32_ps(ki), half);
+		r = _mm_sub_ps(angle, _mm_mul_ps(j, piHi));
+		r = _mm_sub_ps(r, _mm_mul_ps(j, piLo));
+		// Negated when k is even
+		__m128 sign = _mm_xor_ps(_mm_castsi128_ps(_mm_slli_epi32(ki, 31)), _mm_set1_ps(-0.0f));
+		cos = _mm_xor_ps(SinPolySSE(r), sign);
+	}
+
+	MATH_TARGET("sse2")
+	int SinCosSSE(const float* angles, float* sins, float* coss, int end) {
+		int i = 0;
+		for (; i + 4 <= end; i += 4) {
+			__m128 sin;
+			__m128 cos;
+			SinCosSSE(_mm_loadu_ps(angles + i), sin, cos);
+			_mm_storeu_ps(sins + i, sin);
+			_mm_storeu_ps(coss + i, cos);
+		}
+		return i;
+	}
+
+	// Four points per register, the shuffles work within each 128 bit half
+	MATH_TARGET("avx")
+	int TransformAVX(const Matrix3& mat, const Vector2* in, Vector2* out, int end) {
+		const __m256 row0 = _mm256_setr_ps(
+			mat.mat[0][0], mat.mat[0][1], mat.mat[0][0], mat.mat[0][1],
+			mat.mat[0][0], mat.mat[0][1], mat.mat[0][0], mat.mat[0][1]);
+		const __m256 row1 = _mm256_setr_ps(
+			mat.mat[1][0], mat.mat[1][1], mat.mat[1][0], mat.mat[1][1],
+			mat.mat[1][0], mat.mat[1][1], mat.mat[1][0], mat.mat[1][1]);
+		const __m256 row2 = _mm256_setr_ps(
+			mat.mat[2][0], mat.mat[2][1], mat.mat[2][0], mat.mat[2][1],
+			mat.mat[2][0], mat.mat[2][1], mat.mat[2][0], mat.mat[2][1]);
+
+		int i = 0;
+		for (; i + 4 <= end; i += 4) {
+			__m256 p = _mm256_loadu_ps(&in[i].x);
+			__m256 xx = _mm256_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 0, 0));
+			__m256 yy = _mm256_shuffle_ps(p, p, _MM_SHUFFLE(3, 3, 1, 1));
+			__m256 result = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(xx, row0), _mm256_mul_ps(yy, row1)), row2);
+			_mm256_storeu_ps(&out[i].x, result);
+		}
+		return i;
+	}
+
+	MATH_TARGET("avx")
+	int IntegrateAVX(float* pos, const float* vel, float deltaTime, int end) {
+		const __m256 dt = _mm256_set1_ps(deltaTime);
+
+		int i = 0;
+		for (; i + 8 <= end; i += 8) {
+			__m256 p = _mm256_add_ps(_mm256_loadu_ps(pos + i), _mm256_mul_ps(_mm256_loadu_ps(vel + i), dt));
+			_mm256_storeu_ps(pos + i, p);
+		}
+		return i;
+	}
+
+	MATH_TARGET("avx")
+	int BoundsAVX(const float* centers, const float* halfExtents, float* mins, float* maxs, int end) {
+		int i = 0;
+		for (; i + 8 <= end; i += 8) {
+			__m256 c = _mm256_loadu_ps(centers + i);
+			__m256 h = _mm256_loadu_ps(halfExtents + i);
+			_mm256_storeu_ps(mins + i, _mm256_sub_ps(c, h));
+			_mm256_storeu_ps(maxs + i, _mm256_add_ps(c, h));
+		}
+		return i;
+	}
+
+	MATH_TARGET("avx")
+	__m256 SinPolyAVX(__m256 r) {
+		__m256 r2 = _mm256_mul_ps(r, r);
+		__m256 p = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(-2.5052108e-8f), r2), _mm256_set1_ps(2.7557319e-6f));
+		p = _mm256_add_ps(_mm256_mul_ps(p, r2), _mm256_set1_ps(-1.9841270e-4f));
+		p = _mm256_add_ps(_mm256_mul_ps(p, r2), _mm256_set1_ps(8.3333333e-3f));
+		p = _mm256_add_ps(_mm256_mul_ps(p, r2), _mm256_set1_ps(-1.6666667e-1f));
+		return _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(r, r2), p), r);
+	}
+
+	// AVX has no 256 bit integer shifts, so sign bit for odd k comes from k / 2
+	// having a fractional part
+	MATH_TARGET("avx")
+	__m256 OddSignAVX(__m256 k) {
+		__m256 halfK = _mm256_mul_ps(k, _mm256_set1_ps(0.5f));
+		__m256 odd = _mm256_cmp_ps(halfK, _mm256_floor_ps(halfK), _CMP_NEQ_OQ);
+		return _mm256_and_ps(odd, _mm256_set1_ps(-0.0f));
+	}
+
+	MATH_TARGET("avx")
+	void SinCosAVX(__m256 angle, __m256& sin, __m256& cos) {
+		const __m256 invPi = _mm256_set1_ps(1.0f / Math::Pi);
+		const __m256 piHi = _mm256_set1_ps(3.140625f);
+		const __m256 piLo = _mm256_set1_ps(0.00096765358979f);
+		const __m256 half = _mm256_set1_ps(0.5f);
+		const int nearest = _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC;
+
+		__m256 k = _mm256_round_ps(_mm256_mul_ps(angle, invPi), nearest);
+		__m256 r = _mm256_sub_ps(angle, _mm256_mul_ps(k, piHi));
+		r = _mm256_sub_ps(r, _mm256_mul_ps(k, piLo));
+		sin = _mm256_xor_ps(SinPolyAVX(r), OddSignAVX(k));
+
+		k = _mm256_round_ps(_mm256_sub_ps(_mm256_mul_ps(angle, invPi), half), nearest);
+		__m256 j = _mm256_add_ps(k, half);
+		r = _mm256_sub_ps(angle, _mm256_mul_ps(j, piHi));
+		r = _mm256_sub_ps(r, _mm256_mul_ps(j, piLo));
+		cos = _mm256_xor_ps(SinPolyAVX(r), _mm256_xor_ps(OddSignAVX(k), _mm256_set1_ps(-0.0f)));
+	}
+
+	MATH_TARGET("avx")
+	int SinCosAVX(const float* angles, float* sins, float* coss, int end) {
+		int i = 0;
+		for (; i + 8 <= end; i += 8) {
+			__m256 sin;
+			__m256 cos;
+			SinCosAVX(_mm256_loadu_ps(angles + i), sin, cos);
+			_mm256_storeu_ps(sins + i, sin);
+			_mm256_storeu_ps(coss + i, cos);
+		}
+		return i;
+	}
+#endif
+}
+
+Math::SimdLevel Math::BestSimdLevel() {
+#if MATH_SIMD
+	if (SDL_HasAVX()) {
+		return ESimdAVX;
+	}
+	if (SDL_HasSSE2()) {
+		return ESimdSSE;
+	}
+#endif
+	return ESimdScalar;
+}
+
+void Math::SetSimdLevel(SimdLevel level) {
+	sSimdLevel = level <= BestSimdLevel() ? level : BestSimdLevel();
+}
+
+Math::SimdLevel Math::GetSimdLevel() {
+	return sSimdLevel;
+}
+
+const char* Math::SimdLevelName(SimdLevel level) {
+	switch (level) {
+		case ESimdAVX:
+			return "AVX";
+		case ESimdSSE:
+			return "SSE";
+		default:
+			return "scalar";
+	}
+}
+
+void Math::TransformPoints(const Matrix3& mat, const Vector2* in, Vector2* out, int count) {
+	int done = 0;
+#if MATH_SIMD
+	if (sSimdLevel == ESimdAVX) {
+		done = TransformAVX(mat, in, out, count);
+	}
+	else if (sSimdLevel == ESimdSSE) {
+		done = TransformSSE(mat, in, out, count);
+	}
+#endif
+	TransformScalar(mat, in, out, done, count);
+}
+
+void Math::Integrate(Vector2* pos, const Vector2* vel, float deltaTime, int count) {
+	// Same operation on x and y, so run over the points as one array of floats
+	float* p = &pos->x;
+	const float* v = &vel->x;
+	int floats = count * 2;
+
+	int done = 0;
+#if MATH_SIMD
+	if (sSimdLevel == ESimdAVX) {
+		done = IntegrateAVX(p, v, deltaTime, floats);
+	}
+	else if (sSimdLevel == ESimdSSE) {
+		done = IntegrateSSE(p, v, deltaTime, floats);
+	}
+#endif
+	IntegrateScalar(p, v, deltaTime, done, floats);
+}
+
+void Math::ComputeBounds(const Vector2* centers, const Vector2* halfExtents, Vector2* mins, Vector2* maxs, int count) {
+	const float* c = &centers->x;
+	const float* h = &halfExtents->x;
+	float* lo = &mins->x;
+	float* hi = &maxs->x;
+	int floats = count * 2;
+
+	int done = 0;
+#if MATH_SIMD
+	if (sSimdLevel == ESimdAVX) {
+		done = BoundsAVX(c, h, lo, hi, floats);
+	}
+	else if (sSimdLevel == ESimdSSE) {
+		done = BoundsSSE(c, h, lo, hi, floats);
+	}
+#endif
+	BoundsScalar(c, h, lo, hi, done, floats);
+}
+
+void Math::SinCos(const float* angles, float* sins, float* coss, int count) {
+	int done = 0;
+#if MATH_SIMD
+	if (sSimdLevel == ESimdAVX) {
+		done = SinCosAVX(angles, sins, coss, count);
+	}
+	else if (sSimdLevel == ESimdSSE) {
+		done = SinCosSSE(angles, sins, coss, count);
+	}
+#endif
+	SinCosScalar(angles, sins, coss, done, count);
+}
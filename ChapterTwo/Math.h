@@ -102,9 +102,442 @@ namespace Math
 	{
 		return fmod(numer, denom);
 	}
+
+	// Odd polynomial (Taylor to r^11) for sin on [-Pi/2, Pi/2]
+	inline float SinPoly(float r)
+	{
+		float r2 = r * r;
+		float p = -2.5052108e-8f * r2 + 2.7557319e-6f;
+		p = p * r2 + -1.9841270e-4f;
+		p = p * r2 + 8.3333333e-3f;
+		p = p * r2 + -1.6666667e-1f;
+		return r * r2 * p + r;
+	}
+
+	// Fast sin/cos approximations for bulk rotation, within 1e-6 of sinf/cosf
+	// for |angle| up to about 1e4 (SinCos below runs them 4 or 8 angles at a
+	// time, matching these to the last bit or so: the compiler may fuse the
+	// multiply-adds here into FMAs, the SIMD versions never do)
+	inline float FastSin(float angle)
+	{
+		// Bring the angle into [-Pi/2, Pi/2] around the nearest multiple k of Pi,
+		// subtracting Pi in two parts so the high part is exact
+		float k = nearbyintf(angle * (1.0f / Pi));
+		float r = angle - k * 3.140625f;
+		r = r - k * 0.00096765358979f;
+
+		// sin flips sign every Pi
+		float result = SinPoly(r);
+		return (static_cast<int>(k) & 1) ? -result : result;
+	}
+
+	inline float FastCos(float angle)
+	{
+		// Same around the nearest odd multiple of Pi/2, (k + 1/2) Pi,
+		// where cos(angle) = -(-1)^k sin(r)
+		float k = nearbyintf(angle * (1.0f / Pi) - 0.5f);
+		float j = k + 0.5f;
+		float r = angle - j * 3.140625f;
+		r = r - j * 0.00096765358979f;
+
+		float result = SinPoly(r);
+		return (static_cast<int>(k) & 1) ? result : -result;
+	}
 }
 
-struct Vector2 {
+struct Matrix3;
+
+// Row vectors, transformed as v * M (translation in the bottom row)
+struct Vector2
+{
 	float x;
 	float y;
+
+	// Set both components at once
+	void Set(float inX, float inY)
+	{
+		x = inX;
+		y = inY;
+	}
+
+	constexpr float LengthSq() const
+	{
+		return x * x + y * y;
+	}
+
+	float Length() const
+	{
+		return Math::Sqrt(LengthSq());
+	}
+
+	// Normalize this vector (must not be zero length)
+	void Normalize()
+	{
+		float length = Length();
+		x /= length;
+		y /= length;
+	}
+
+	static Vector2 Normalize(const Vector2& vec)
+	{
+		Vector2 temp = vec;
+		temp.Normalize();
+		return temp;
+	}
+
+	static constexpr float Dot(const Vector2& a, const Vector2& b)
+	{
+		return a.x * b.x + a.y * b.y;
+	}
+
+	// Z of the 3D cross product (positive when b is counterclockwise of a)
+	static constexpr float Cross(const Vector2& a, const Vector2& b)
+	{
+		return a.x * b.y - a.y * b.x;
+	}
+
+	static constexpr Vector2 Lerp(const Vector2& a, const Vector2& b, float f)
+	{
+		return Vector2{ a.x + (b.x - a.x) * f, a.y + (b.y - a.y) * f };
+	}
+
+	// Reflect v about (normalized) n
+	static constexpr Vector2 Reflect(const Vector2& v, const Vector2& n)
+	{
+		return Vector2{ v.x - 2.0f * Dot(v, n) * n.x, v.y - 2.0f * Dot(v, n) * n.y };
+	}
+
+	// Transform by a matrix, w = 1 for points and 0 for directions
+	static constexpr Vector2 Transform(const Vector2& vec, const Matrix3& mat, float w = 1.0f);
+
+	constexpr Vector2& operator+=(const Vector2& right)
+	{
+		x += right.x;
+		y += right.y;
+		return *this;
+	}
+
+	constexpr Vector2& operator-=(const Vector2& right)
+	{
+		x -= right.x;
+		y -= right.y;
+		return *this;
+	}
+
+	constexpr Vector2& operator*=(float scalar)
+	{
+		x *= scalar;
+		y *= scalar;
+		return *this;
+	}
+
+	constexpr Vector2& operator/=(float scalar)
+	{
+		x /= scalar;
+		y /= scalar;
+		return *this;
+	}
+
+	static const Vector2 Zero;
+	static const Vector2 UnitX;
+	static const Vector2 UnitY;
 };
+
+constexpr Vector2 operator+(const Vector2& a, const Vector2& b)
+{
+	return Vector2{ a.x + b.x, a.y + b.y };
+}
+
+constexpr Vector2 operator-(const Vector2& a, const Vector2& b)
+{
+	return Vector2{ a.x - b.x, a.y - b.y };
+}
+
+constexpr Vector2 operator-(const Vector2& vec)
+{
+	return Vector2{ -vec.x, -vec.y };
+}
+
+// Component-wise
+constexpr Vector2 operator*(const Vector2& a, const Vector2& b)
+{
+	return Vector2{ a.x * b.x, a.y * b.y };
+}
+
+constexpr Vector2 operator*(const Vector2& vec, float scalar)
+{
+	return Vector2{ vec.x * scalar, vec.y * scalar };
+}
+
+constexpr Vector2 operator*(float scalar, const Vector2& vec)
+{
+	return Vector2{ vec.x * scalar, vec.y * scalar };
+}
+
+constexpr Vector2 operator/(const Vector2& vec, float scalar)
+{
+	return Vector2{ vec.x / scalar, vec.y / scalar };
+}
+
+constexpr bool operator==(const Vector2& a, const Vector2& b)
+{
+	return a.x == b.x && a.y == b.y;
+}
+
+constexpr bool operator!=(const Vector2& a, const Vector2& b)
+{
+	return !(a == b);
+}
+
+struct Vector3
+{
+	float x;
+	float y;
+	float z;
+
+	void Set(float inX, float inY, float inZ)
+	{
+		x = inX;
+		y = inY;
+		z = inZ;
+	}
+
+	constexpr float LengthSq() const
+	{
+		return x * x + y * y + z * z;
+	}
+
+	float Length() const
+	{
+		return Math::Sqrt(LengthSq());
+	}
+
+	// Normalize this vector (must not be zero length)
+	void Normalize()
+	{
+		float length = Length();
+		x /= length;
+		y /= length;
+		z /= length;
+	}
+
+	static Vector3 Normalize(const Vector3& vec)
+	{
+		Vector3 temp = vec;
+		temp.Normalize();
+		return temp;
+	}
+
+	static constexpr float Dot(const Vector3& a, const Vector3& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	static constexpr Vector3 Cross(const Vector3& a, const Vector3& b)
+	{
+		return Vector3{ a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+	}
+
+	static constexpr Vector3 Lerp(const Vector3& a, const Vector3& b, float f)
+	{
+		return Vector3{ a.x + (b.x - a.x) * f, a.y + (b.y - a.y) * f, a.z + (b.z - a.z) * f };
+	}
+
+	// v * M with all three components (homogeneous 2D when z is the w)
+	static constexpr Vector3 Transform(const Vector3& vec, const Matrix3& mat);
+
+	constexpr Vector3& operator+=(const Vector3& right)
+	{
+		x += right.x;
+		y += right.y;
+		z += right.z;
+		return *this;
+	}
+
+	constexpr Vector3& operator-=(const Vector3& right)
+	{
+		x -= right.x;
+		y -= right.y;
+		z -= right.z;
+		return *this;
+	}
+
+	constexpr Vector3& operator*=(float scalar)
+	{
+		x *= scalar;
+		y *= scalar;
+		z *= scalar;
+		return *this;
+	}
+
+	constexpr Vector3& operator/=(float scalar)
+	{
+		x /= scalar;
+		y /= scalar;
+		z /= scalar;
+		return *this;
+	}
+
+	static const Vector3 Zero;
+	static const Vector3 UnitX;
+	static const Vector3 UnitY;
+	static const Vector3 UnitZ;
+};
+
+constexpr Vector3 operator+(const Vector3& a, const Vector3& b)
+{
+	return Vector3{ a.x + b.x, a.y + b.y, a.z + b.z };
+}
+
+constexpr Vector3 operator-(const Vector3& a, const Vector3& b)
+{
+	return Vector3{ a.x - b.x, a.y - b.y, a.z - b.z };
+}
+
+constexpr Vector3 operator-(const Vector3& vec)
+{
+	return Vector3{ -vec.x, -vec.y, -vec.z };
+}
+
+// Component-wise
+constexpr Vector3 operator*(const Vector3& a, const Vector3& b)
+{
+	return Vector3{ a.x * b.x, a.y * b.y, a.z * b.z };
+}
+
+constexpr Vector3 operator*(const Vector3& vec, float scalar)
+{
+	return Vector3{ vec.x * scalar, vec.y * scalar, vec.z * scalar };
+}
+
+constexpr Vector3 operator*(float scalar, const Vector3& vec)
+{
+	return Vector3{ vec.x * scalar, vec.y * scalar, vec.z * scalar };
+}
+
+constexpr Vector3 operator/(const Vector3& vec, float scalar)
+{
+	return Vector3{ vec.x / scalar, vec.y / scalar, vec.z / scalar };
+}
+
+constexpr bool operator==(const Vector3& a, const Vector3& b)
+{
+	return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+constexpr bool operator!=(const Vector3& a, const Vector3& b)
+{
+	return !(a == b);
+}
+
+// 2D affine transform for row vectors: scale/rotation in the top left 2x2,
+// translation in the bottom row
+struct Matrix3
+{
+	float mat[3][3];
+
+	static Matrix3 CreateScale(float xScale, float yScale)
+	{
+		return Matrix3{ {
+			{ xScale, 0.0f, 0.0f },
+			{ 0.0f, yScale, 0.0f },
+			{ 0.0f, 0.0f, 1.0f }
+		} };
+	}
+
+	static Matrix3 CreateScale(float scale)
+	{
+		return CreateScale(scale, scale);
+	}
+
+	// Counterclockwise rotation in radians (y up)
+	static Matrix3 CreateRotation(float theta)
+	{
+		float c = Math::Cos(theta);
+		float s = Math::Sin(theta);
+		return Matrix3{ {
+			{ c, s, 0.0f },
+			{ -s, c, 0.0f },
+			{ 0.0f, 0.0f, 1.0f }
+		} };
+	}
+
+	static Matrix3 CreateTranslation(const Vector2& trans)
+	{
+		return Matrix3{ {
+			{ 1.0f, 0.0f, 0.0f },
+			{ 0.0f, 1.0f, 0.0f },
+			{ trans.x, trans.y, 1.0f }
+		} };
+	}
+
+	// a then b
+	friend constexpr Matrix3 operator*(const Matrix3& a, const Matrix3& b)
+	{
+		Matrix3 result{};
+		for (int row = 0; row < 3; row++) {
+			for (int col = 0; col < 3; col++) {
+				result.mat[row][col] = a.mat[row][0] * b.mat[0][col]
+					+ a.mat[row][1] * b.mat[1][col]
+					+ a.mat[row][2] * b.mat[2][col];
+			}
+		}
+		return result;
+	}
+
+	constexpr Matrix3& operator*=(const Matrix3& right)
+	{
+		*this = *this * right;
+		return *this;
+	}
+
+	static const Matrix3 Identity;
+};
+
+constexpr Vector2 Vector2::Transform(const Vector2& vec, const Matrix3& mat, float w)
+{
+	return Vector2{
+		vec.x * mat.mat[0][0] + vec.y * mat.mat[1][0] + w * mat.mat[2][0],
+		vec.x * mat.mat[0][1] + vec.y * mat.mat[1][1] + w * mat.mat[2][1]
+	};
+}
+
+constexpr Vector3 Vector3::Transform(const Vector3& vec, const Matrix3& mat)
+{
+	return Vector3{
+		vec.x * mat.mat[0][0] + vec.y * mat.mat[1][0] + vec.z * mat.mat[2][0],
+		vec.x * mat.mat[0][1] + vec.y * mat.mat[1][1] + vec.z * mat.mat[2][1],
+		vec.x * mat.mat[0][2] + vec.y * mat.mat[1][2] + vec.z * mat.mat[2][2]
+	};
+}
+
+// Batch operations over arrays (Math.cpp), run 4 (SSE) or 8 (AVX) floats at a
+// time when the CPU has it. Same operations in the same order as the scalar
+// versions, so results agree to rounding (exactly, unless the compiler fuses
+// the scalar multiply-adds into FMAs).
+// Outputs may be the same arrays as the inputs.
+namespace Math
+{
+	enum SimdLevel
+	{
+		ESimdScalar,
+		ESimdSSE,
+		ESimdAVX
+	};
+
+	// Widest level this build and CPU can run
+	SimdLevel BestSimdLevel();
+	// Used by the batch operations (capped at BestSimdLevel), mainly for benchmarks
+	void SetSimdLevel(SimdLevel level);
+	SimdLevel GetSimdLevel();
+	const char* SimdLevelName(SimdLevel level);
+
+	// out[i] = Vector2::Transform(in[i], mat)
+	void TransformPoints(const Matrix3& mat, const Vector2* in, Vector2* out, int count);
+	// pos[i] += vel[i] * deltaTime
+	void Integrate(Vector2* pos, const Vector2* vel, float deltaTime, int count);
+	// Box of halfExtents[i] around centers[i]
+	void ComputeBounds(const Vector2* centers, const Vector2* halfExtents, Vector2* mins, Vector2* maxs, int count);
+	// FastSin/FastCos of every angle
+	void SinCos(const float* angles, float* sins, float* coss, int count);
+}
@@ -0,0 +1,194 @@
+#include "ObjectPool.h"
+#include "SDL.h"
+#include <atomic>
+#include <new>
+
+namespace
+{
+	// Size classes are 16 bytes apart (keeps every block 16 byte aligned)
+	const size_t SizeClassStep = 16;
+	const size_t MaxPooledSize = 512;
+	const int NumSizeClasses = static_cast<int>(MaxPooledSize / SizeClassStep);
+
+	std::atomic<int> sHeapAllocations(0);
+
+	// Typed pools are created on first use, possibly on a job thread
+	std::mutex sTypedMutex;
+	std::vector<ObjectPool*>& TypedPools() {
+		static std::vector<ObjectPool*>* pools = new std::vector<ObjectPool*>();
+		return *pools;
+	}
+}
+
+ObjectPool::ObjectPool(size_t blockSize, int blocksPerSlab, const char* name)
+	: mBlockSize(blockSize < sizeof(FreeBlock) ? sizeof(FreeBlock) : blockSize)
+	, mBlocksPerSlab(blocksPerSlab)
+	, mName(name)
+	, mFreeList(nullptr)
+	, mStats{}
+{}
+
+ObjectPool::~ObjectPool() {
+	for (auto slab : mSlabs) {
+		::operator delete(slab);
+	}
+}
+
+void* ObjectPool::Allocate() {
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	if (!mFreeList) {
+		AddSlab();
+	}
+
+	FreeBlock* block = mFreeList;
+	mFreeList = block->mNext;
+
+	mStats.mAllocations++;
+	mStats.mLive++;
+	if (mStats.mLive > mStats.mPeakLive) {
+		mStats.mPeakLive = mStats.mLive;
+	}
+
+	return block;
+}
+
+void ObjectPool::Free(void* block) {
+	if (!block) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	FreeBlock* freed = static_cast<FreeBlock*>(block);
+	freed->mNext = mFreeList;
+	mFreeList = freed;
+
+	mStats.mFrees++;
+	mStats.mLive--;
+}
+
+ObjectPool::Stats ObjectPool::GetStats() {
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mStats;
+}
+
+void ObjectPool::AddSlab() {
+	char* slab = static_cast<char*>(::operator new(mBlockSize * mBlocksPerSlab));
+	mSlabs.emplace_back(slab);
+	mStats.mSlabs++;
+
+	// Thread the new blocks onto the free list, first block at the head
+	for (int i = mBlocksPerSlab - 1; i >= 0; i--) {
+		FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + i * mBlockSize);
+		block->mNext = mFreeList;
+		mFreeList = block;
+	}
+}
+
+ObjectPool* ObjectPool::GetSizeClass(size_t size) {
+	if (size == 0 || size > MaxPooledSize) {
+		return nullptr;
+	}
+
+	// Built on first use and never torn down, objects can still
+	// be freed from other static destructors at exit
+	static ObjectPool** pools = [] {
+		ObjectPool** classes = new ObjectPool*[NumSizeClasses];
+		for (int i = 0; i < NumSizeClasses; i++) {
+			classes[i] = new ObjectPool((i + 1) * SizeClassStep);
+		}
+		return classes;
+	}();
+
+	return pools[(size - 1) / SizeClassStep];
+}
+
+ObjectPool* ObjectPool::Register(ObjectPool* pool) {
+	std::lock_guard<std::mutex> lock(sTypedMutex);
+	TypedPools().emplace_back(pool);
+	return pool;
+}
+
+std::vector<ObjectPool*> ObjectPool::GetTypedPools() {
+	std::lock_guard<std::mutex> lock(sTypedMutex);
+	return TypedPools();
+}
+
+void* ObjectPool::AllocateSized(size_t size) {
+	ObjectPool* pool = GetSizeClass(size);
+	if (!pool) {
+		sHeapAllocations++;
+		return ::operator new(size);
+	}
+	return pool->Allocate();
+}
+
+void ObjectPool::FreeSized(void* ptr, size_t size) {
+	ObjectPool* pool = GetSizeClass(size);
+	if (!pool) {
+		::operator delete(ptr);
+		return;
+	}
+	pool->Free(ptr);
+}
+
+ObjectPool::Stats ObjectPool::GetTotalStats() {
+	Stats total{};
+
+	std::vector<ObjectPool*> pools = GetTypedPools();
+	for (size_t size = SizeClassStep; size <= MaxPooledSize; size += SizeClassStep) {
+		pools.emplace_back(GetSizeClass(size));
+	}
+
+	for (auto pool : pools) {
+		Stats stats = pool->GetStats();
+		total.mAllocations += stats.mAllocations;
+		total.mFrees += stats.mFrees;
+		total.mLive += stats.mLive;
+		total.mPeakLive += stats.mPeakLive;
+		total.mSlabs += stats.mSlabs;
+	}
+	total.mHeapAllocations = sHeapAllocations;
+
+	return total;
+}
+
+void ObjectPool::LogStats() {
+	Stats total = GetTotalStats();
+	SDL_Log("ObjectPool: %d allocations, %d frees, %d live (peak %d), %d slabs, %d too big for a pool",
+		total.mAllocations,
+		total.mFrees,
+		total.mLive,
+		total.mPeakLive,
+		total.mSlabs,
+		total.mHeapAllocations
+	);
+
+	// Only the pools that saw any use
+	for (auto pool : GetTypedPools()) {
+		Stats stats = pool->GetStats();
+		if (stats.mAllocations > 0) {
+			SDL_Log("  %s (%zu bytes): %d allocations, %d live (peak %d), %d slabs",
+				pool->GetName(),
+				pool->GetBlockSize(),
+				stats.mAllocations,
+				stats.mLive,
+				stats.mPeakLive,
+				stats.mSlabs
+			);
+		}
+	}
+	for (size_t size = SizeClassStep; size <= MaxPooledSize; size += SizeClassStep) {
+		Stats stats = GetSizeClass(size)->GetStats();
+		if (stats.mAllocations > 0) {
+			SDL_Log("  %4zu bytes: %d allocations, %d live (peak %d), %d slabs",
+				size,
+				stats.mAllocations,
+				stats.mLive,
+				stats.mPeakLive,
+				stats.mSlabs
+			);
+		}
+	}
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+// Fixed-size block allocator.
+// Blocks are carved out of larger slabs and recycled through a free list,
+// so spawning/despawning objects doesn't go near the general heap once warm.
+// Classes that declare OBJECT_POOL get a pool of their own, so each type's
+// objects sit together and only contend with each other for the pool's lock.
+// Anything else allocated through the pools (a subclass that doesn't declare
+// its own) goes to shared size classes 16 bytes apart.
+class ObjectPool
+{
+public:
+	explicit ObjectPool(size_t blockSize, int blocksPerSlab = 256, const char* name = nullptr);
+	~ObjectPool();
+
+	void* Allocate();
+	void Free(void* block);
+	size_t GetBlockSize() const { return mBlockSize; };
+	// Type the pool is for (nullptr for a size class)
+	const char* GetName() const { return mName; };
+
+	struct Stats {
+		int mAllocations;
+		int mFrees;
+		int mLive;
+		int mPeakLive;
+		int mSlabs;
+		// Objects too big for any size class (went straight to the heap)
+		int mHeapAllocations;
+	};
+	Stats GetStats();
+
+	// Pick the pool for an object of this size (falls back to the heap if too big)
+	static void* AllocateSized(size_t size);
+	static void FreeSized(void* ptr, size_t size);
+
+	// Pool for objects of exactly type T (created on first use, never torn down)
+	template <typename T>
+	static ObjectPool* ForType(const char* name) {
+		static ObjectPool* pool = Register(new ObjectPool(sizeof(T), 256, name));
+		return pool;
+	}
+	// T's own pool when size is T's, otherwise the object is a subclass
+	// without a pool of its own and goes to the size classes
+	template <typename T>
+	static void* AllocateTyped(size_t size, const char* name) {
+		return size == sizeof(T) ? ForType<T>(name)->Allocate() : AllocateSized(size);
+	}
+	template <typename T>
+	static void FreeTyped(void* ptr, size_t size, const char* name) {
+		if (size == sizeof(T)) {
+			ForType<T>(name)->Free(ptr);
+		}
+		else {
+			FreeSized(ptr, size);
+		}
+	}
+
+	// Summed over every typed pool and size class
+	static Stats GetTotalStats();
+	static void LogStats();
+
+private:
+	struct FreeBlock {
+		FreeBlock* mNext;
+	};
+
+	void AddSlab();
+	// nullptr if the size is past the largest class
+	static ObjectPool* GetSizeClass(size_t size);
+	// Track a typed pool for the stats
+	static ObjectPool* Register(ObjectPool* pool);
+	// Every typed pool so far
+	static std::vector<ObjectPool*> GetTypedPools();
+
+	size_t mBlockSize;
+	int mBlocksPerSlab;
+	const char* mName;
+
+	// Actors can be spawned from job threads
+	std::mutex mMutex;
+	FreeBlock* mFreeList;
+	std::vector<char*> mSlabs;
+	Stats mStats;
+};
+
+// Declare inside a class (or subclass) of Actor or Component to give it its
+// own pool, e.g. class Ship : public Actor { public: OBJECT_POOL(Ship) ... };
+// Relies on the virtual destructor, so delete sees the most derived class.
+#define OBJECT_POOL(Class) \
+	static void* operator new(size_t size) { return ObjectPool::AllocateTyped<Class>(size, #Class); } \
+	static void operator delete(void* ptr, size_t size) { ObjectPool::FreeTyped<Class>(ptr, size, #Class); }
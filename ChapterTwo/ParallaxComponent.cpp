@@ -0,0 +1,138 @@
+#include "ParallaxComponent.h"
+#include "Actor.h"
+#include "Game.h"
+#include "Camera.h"
+#include "SpriteBatch.h"
+#include "Profiler.h"
+#include <cmath>
+
+ParallaxComponent::ParallaxComponent(Actor* owner, int drawOrder)
+	: SpriteComponent(owner, drawOrder)
+	, mBlitsDrawn(0)
+{}
+
+int ParallaxComponent::AddLayer(const std::vector<TextureHandle>& panels, float speed, bool tileVertically) {
+	mLayers.emplace_back(Layer{ panels, tileVertically });
+	mOffsets.emplace_back(0.0f);
+	mSpeeds.emplace_back(speed);
+	mWidths.emplace_back(0.0f);
+	return static_cast<int>(mLayers.size()) - 1;
+}
+
+int ParallaxComponent::AddLayer(const TextureHandle& texture, float speed, bool tileVertically) {
+	return AddLayer(std::vector<TextureHandle>{ texture }, speed, tileVertically);
+}
+
+void ParallaxComponent::Update(float deltaTime) {
+	SpriteComponent::Update(deltaTime);
+
+	// Scrolling left moves further into the strip
+	const int count = static_cast<int>(mOffsets.size());
+	float* offsets = mOffsets.data();
+	const float* speeds = mSpeeds.data();
+	const float* widths = mWidths.data();
+	for (int i = 0; i < count; i++) {
+		float offset = offsets[i] - speeds[i] * deltaTime;
+		float width = widths[i];
+		if (width > 0.0f) {
+			offset -= std::floor(offset / width) * width;
+		}
+		offsets[i] = offset;
+	}
+}
+
+void ParallaxComponent::Draw(SpriteBatch* batch) {
+	PROFILE_SCOPE("ParallaxComponent::Draw");
+	mBlitsDrawn = 0;
+
+	Game* game = mOwner->GetGame();
+	const Vector2& view = game->GetCamera()->GetViewSize();
+	int viewWidth = static_cast<int>(view.x);
+	int viewHeight = static_cast<int>(view.y);
+	float centerY = mOwner->GetDrawPosition().y;
+	// Offsets are as of the latest step, back them up to where the
+	// scroll was at the interpolated time
+	float lagTime = (1.0f - game->GetInterpolation()) * game->GetSimStep();
+
+	for (size_t i = 0; i < mLayers.size(); i++) {
+		const Layer& layer = mLayers[i];
+
+		// Panels may still be loading, the strip's width is known once they all have
+		if (mWidths[i] <= 0.0f) {
+			int width = 0;
+			for (const auto& panel : layer.mPanels) {
+				if (!panel) {
+					width = 0;
+					break;
+				}
+				width += panel.GetWidth();
+			}
+			if (width <= 0) {
+				continue;
+			}
+			mWidths[i] = static_cast<float>(width);
+		}
+
+		int texHeight = layer.mPanels[0].GetHeight();
+		if (texHeight <= 0) {
+			continue;
+		}
+		float scale = layer.mTileVertically ? 1.0f : static_cast<float>(viewHeight) / texHeight;
+		int height = static_cast<int>(texHeight * scale);
+
+		float offset = mOffsets[i] + mSpeeds[i] * lagTime;
+		offset -= std::floor(offset / mWidths[i]) * mWidths[i];
+
+		int top = static_cast<int>(centerY - height / 2);
+		if (layer.mTileVertically) {
+			// Back up to the first row that reaches the top of the view
+			while (top > 0) {
+				top -= height;
+			}
+			for (; top < viewHeight; top += height) {
+				DrawRow(batch, layer, scale, offset, top, height, viewWidth);
+			}
+		}
+		else {
+			DrawRow(batch, layer, scale, offset, top, height, viewWidth);
+		}
+	}
+}
+
+void ParallaxComponent::DrawRow(SpriteBatch* batch, const Layer& layer, float scale, float offset,
+	int top, int height, int viewWidth)
+{
+	Camera* camera = mOwner->GetGame()->GetCamera();
+
+	// Find the panel the left edge of the view falls in
+	int panel = 0;
+	int local = static_cast<int>(offset);
+	while (local >= layer.mPanels[panel].GetWidth()) {
+		local -= layer.mPanels[panel].GetWidth();
+		panel = (panel + 1) % static_cast<int>(layer.mPanels.size());
+	}
+
+	// Cut what's visible out of each panel in turn (two at most while the
+	// panels are as wide as the view)
+	int x = 0;
+	while (x < viewWidth) {
+		const TextureHandle& texture = layer.mPanels[panel];
+		int texWidth = texture.GetWidth();
+		int destWidth = Math::Min(static_cast<int>(std::ceil((texWidth - local) * scale)), viewWidth - x);
+		int srcWidth = Math::Min(static_cast<int>(std::ceil(destWidth / scale)), texWidth - local);
+		if (destWidth <= 0 || srcWidth <= 0) {
+			break;
+		}
+
+		SDL_Rect src{ local, 0, srcWidth, texture.GetHeight() };
+		SDL_Rect dest{ x, top, destWidth, height };
+		if (camera->SubmitScreen(dest)) {
+			batch->Draw(texture, src, dest);
+			mBlitsDrawn++;
+		}
+
+		x += destWidth;
+		local = 0;
+		panel = (panel + 1) % static_cast<int>(layer.mPanels.size());
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "SpriteComponent.h"
+#include "Math.h"
+#include <vector>
+
+// Scrolling background made of parallax layers, drawn in screen space.
+// Each layer is a strip of panels (usually one texture) that wraps around
+// horizontally. A layer is drawn by cutting source rects out of its panels,
+// so a layer whose panels are at least as wide as the view costs at most two
+// blits per row, however far it has scrolled.
+// Layers are drawn back to front in the order they were added.
+class ParallaxComponent : public SpriteComponent {
+public:
+	OBJECT_POOL(ParallaxComponent)
+	// Set draw order to lower (so it's in background)
+	ParallaxComponent(class Actor* owner, int drawOrder = 10);
+
+	// Add a layer scrolling at speed pixels per second (negative scrolls left)
+	// Layers are scaled to the view height and centered on the owner vertically,
+	// unless tiled vertically, then they're drawn at their own size and repeated
+	// to cover the view. Returns the layer's index.
+	int AddLayer(const std::vector<TextureHandle>& panels, float speed, bool tileVertically = false);
+	int AddLayer(const TextureHandle& texture, float speed, bool tileVertically = false);
+	void SetLayerSpeed(int layer, float speed) { mSpeeds[layer] = speed; };
+	int GetNumLayers() const { return static_cast<int>(mLayers.size()); };
+
+	void Update(float deltaTime) override;
+	void Draw(class SpriteBatch* batch) override;
+	// Screen space, never culled as a whole (rows are counted as they're drawn)
+	bool Cull(class Camera*) override { return false; };
+
+	// Blits queued by the last Draw
+	int GetBlitsDrawn() const { return mBlitsDrawn; };
+
+private:
+	struct Layer {
+		std::vector<TextureHandle> mPanels;
+		bool mTileVertically;
+	};
+
+	// Draw one row of a layer starting at texture x offset
+	void DrawRow(class SpriteBatch* batch, const Layer& layer, float scale, float offset, int top, int height, int viewWidth);
+
+	// Cold layer data
+	std::vector<Layer> mLayers;
+	// Hot layer state, walked by Update in one loop
+	// Scroll position into the strip (unscaled texture pixels, 0 to width)
+	std::vector<float> mOffsets;
+	std::vector<float> mSpeeds;
+	// Width of the whole strip (0 until every panel has loaded)
+	std::vector<float> mWidths;
+
+	int mBlitsDrawn;
+};
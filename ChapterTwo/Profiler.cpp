@@ -0,0 +1,205 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> Profiler::sEnabled(false);
+
+namespace
+{
+	struct Event {
+		const char* mName;
+		Uint64 mStart;
+		Uint64 mEnd;
+	};
+
+	// One per thread that has recorded anything
+	struct ThreadBuffer {
+		int mThreadId;
+		std::vector<Event> mEvents;
+		// Slot the next event goes in
+		int mNext;
+		// Number of valid events (up to RingSize)
+		int mCount;
+		// Owned by a live thread (buffers of finished threads get reused)
+		bool mInUse;
+	};
+
+	std::mutex sBuffersMutex;
+	std::vector<std::unique_ptr<ThreadBuffer>> sBuffers;
+
+	ThreadBuffer* AcquireBuffer() {
+		std::lock_guard<std::mutex> lock(sBuffersMutex);
+
+		for (auto& buffer : sBuffers) {
+			if (!buffer->mInUse) {
+				buffer->mInUse = true;
+				return buffer.get();
+			}
+		}
+
+		ThreadBuffer* buffer = new ThreadBuffer();
+		buffer->mThreadId = static_cast<int>(sBuffers.size());
+		buffer->mEvents.resize(Profiler::RingSize);
+		buffer->mNext = 0;
+		buffer->mCount = 0;
+		buffer->mInUse = true;
+		sBuffers.emplace_back(buffer);
+
+		return buffer;
+	}
+
+	// Hands the buffer back when the thread exits
+	struct BufferOwner {
+		ThreadBuffer* mBuffer = nullptr;
+
+		~BufferOwner() {
+			if (mBuffer) {
+				std::lock_guard<std::mutex> lock(sBuffersMutex);
+				mBuffer->mInUse = false;
+			}
+		}
+	};
+
+	thread_local BufferOwner tBufferOwner;
+
+	double TicksToMicroseconds(Uint64 ticks) {
+		return static_cast<double>(ticks) * 1e6 / SDL_GetPerformanceFrequency();
+	}
+
+	// Call fn on every recorded event, oldest first per thread
+	template <typename Fn>
+	void ForEachEvent(Fn fn) {
+		std::lock_guard<std::mutex> lock(sBuffersMutex);
+
+		for (auto& buffer : sBuffers) {
+			int first = buffer->mCount < Profiler::RingSize ? 0 : buffer->mNext;
+			for (int i = 0; i < buffer->mCount; i++) {
+				fn(buffer->mThreadId, buffer->mEvents[(first + i) % Profiler::RingSize]);
+			}
+		}
+	}
+}
+
+void Profiler::SetEnabled(bool enabled) {
+	sEnabled = enabled;
+}
+
+void Profiler::Record(const char* name, Uint64 start, Uint64 end) {
+	ThreadBuffer* buffer = tBufferOwner.mBuffer;
+	if (!buffer) {
+		buffer = AcquireBuffer();
+		tBufferOwner.mBuffer = buffer;
+	}
+
+	buffer->mEvents[buffer->mNext] = Event{ name, start, end };
+	buffer->mNext = (buffer->mNext + 1) % RingSize;
+	if (buffer->mCount < RingSize) {
+		buffer->mCount++;
+	}
+}
+
+void Profiler::LogSummary() {
+	// Durations per zone (keyed by contents, the same literal
+	// can have a different address in each translation unit)
+	std::map<std::string, std::vector<double>> zones;
+	ForEachEvent([&zones](int, const Event& event) {
+		zones[event.mName].emplace_back(TicksToMicroseconds(event.mEnd - event.mStart));
+	});
+
+	// Most total time first
+	struct Row {
+		const std::string* mName;
+		size_t mCount;
+		double mTotal;
+		double mMin;
+		double mAvg;
+		double mP99;
+	};
+	std::vector<Row> rows;
+
+	for (auto& zone : zones) {
+		std::vector<double>& times = zone.second;
+		double total = 0.0;
+		for (double t : times) {
+			total += t;
+		}
+
+		size_t p99Index = (times.size() * 99) / 100;
+		std::nth_element(times.begin(), times.begin() + p99Index, times.end());
+		double p99 = times[p99Index];
+		double min = *std::min_element(times.begin(), times.end());
+
+		rows.emplace_back(Row{ &zone.first, times.size(), total, min, total / times.size(), p99 });
+	}
+
+	std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) {
+		return a.mTotal > b.mTotal;
+	});
+
+	SDL_Log("Profiler: %zu zones (most recent %d per thread, times in us)", rows.size(), RingSize);
+	for (const Row& row : rows) {
+		SDL_Log("  %-24s %8zu calls  total %10.1f  min %8.2f  avg %8.2f  p99 %8.2f",
+			row.mName->c_str(),
+			row.mCount,
+			row.mTotal,
+			row.mMin,
+			row.mAvg,
+			row.mP99
+		);
+	}
+}
+
+bool Profiler::WriteChromeTrace(const std::string& fileName) {
+	FILE* file = fopen(fileName.c_str(), "w");
+	if (!file) {
+		SDL_Log("Failed to open trace file: %s", fileName.c_str());
+		return false;
+	}
+
+	// Timestamps relative to the first event so they stay readable
+	Uint64 origin = ~static_cast<Uint64>(0);
+	ForEachEvent([&origin](int, const Event& event) {
+		origin = std::min(origin, event.mStart);
+	});
+
+	fprintf(file, "{\"traceEvents\":[\n");
+
+	bool first = true;
+	ForEachEvent([&](int threadId, const Event& event) {
+		// Zone names are code literals, only quotes and backslashes need escaping
+		std::string name;
+		for (const char* c = event.mName; *c; c++) {
+			if (*c == '"' || *c == '\\') {
+				name += '\\';
+			}
+			name += *c;
+		}
+
+		fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+			first ? "" : ",\n",
+			name.c_str(),
+			threadId,
+			TicksToMicroseconds(event.mStart - origin),
+			TicksToMicroseconds(event.mEnd - event.mStart)
+		);
+		first = false;
+	});
+
+	fprintf(file, "\n]}\n");
+	fclose(file);
+
+	return true;
+}
+
+void Profiler::Clear() {
+	std::lock_guard<std::mutex> lock(sBuffersMutex);
+
+	for (auto& buffer : sBuffers) {
+		buffer->mNext = 0;
+		buffer->mCount = 0;
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include "SDL.h"
+#include <atomic>
+#include <string>
+
+// Build with PROFILER_ENABLED=0 to compile every zone out
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+// Scoped timing zones for finding where a frame goes.
+// Each thread records into its own ring buffer (no locking on the hot path),
+// so the buffers hold a rolling window of the most recent zones.
+// Nothing is recorded until SetEnabled(true), a disabled zone costs one load.
+// LogSummary/WriteChromeTrace read every thread's buffer, so only call them
+// between frames while the job threads are idle.
+namespace Profiler
+{
+	void SetEnabled(bool enabled);
+	inline bool IsEnabled();
+
+	// Zones kept per thread before the oldest get overwritten
+	const int RingSize = 1 << 16;
+
+	// Add a finished zone to the calling thread's buffer
+	// (name must outlive the profiler, i.e. a string literal)
+	void Record(const char* name, Uint64 start, Uint64 end);
+
+	// Log count, min, avg and p99 per zone over what's in the buffers
+	void LogSummary();
+	// Write the buffers out as Chrome trace events (chrome://tracing, Perfetto)
+	bool WriteChromeTrace(const std::string& fileName);
+	// Throw away everything recorded so far
+	void Clear();
+
+	extern std::atomic<bool> sEnabled;
+
+	bool IsEnabled() {
+		return sEnabled.load(std::memory_order_relaxed);
+	}
+
+	// Times the enclosing scope (use PROFILE_SCOPE rather than this directly)
+	class ScopedZone
+	{
+	public:
+		explicit ScopedZone(const char* name)
+			: mName(name)
+			, mStart(IsEnabled() ? SDL_GetPerformanceCounter() : 0)
+		{}
+
+		~ScopedZone() {
+			if (mStart) {
+				Record(mName, mStart, SDL_GetPerformanceCounter());
+			}
+		}
+
+		ScopedZone(const ScopedZone&) = delete;
+		ScopedZone& operator=(const ScopedZone&) = delete;
+
+	private:
+		const char* mName;
+		Uint64 mStart;
+	};
+}
+
+#if PROFILER_ENABLED
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) Profiler::ScopedZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name)
+#endif
@@ -8,21 +8,22 @@ Ship::Ship(Game* game)
 	, mDownSpeed(0.0f)
 {
 	AnimSpriteComponent* asc = new AnimSpriteComponent(this);
-	std::vector<SDL_Texture*> anims = {
-		game->GetTexture("Assets/Ship01.png"),
-		game->GetTexture("Assets/Ship02.png"),
-		game->GetTexture("Assets/Ship03.png"),
-		game->GetTexture("Assets/Ship04.png")
+	std::vector<TextureHandle> anims = {
+		game->GetTextureAsync("Assets/Ship01.png"),
+		game->GetTextureAsync("Assets/Ship02.png"),
+		game->GetTextureAsync("Assets/Ship03.png"),
+		game->GetTextureAsync("Assets/Ship04.png")
 	};
 	asc->SetAnimTextures(anims, "Ship Fly");
+
+	// Input is read in ProcessInput, the update only moves the ship
+	SetUpdateAccess(EAccessSelf);
 }
 
 void Ship::UpdateActor(float deltaTime) {
 	Actor::UpdateActor(deltaTime);
 	// Update position based on speed and delta time
-	Vector2 pos = GetPosition();
-	pos.x += mRightSpeed * deltaTime;
-	pos.y += mDownSpeed * deltaTime;
+	Vector2 pos = GetPosition() + Vector2{ mRightSpeed, mDownSpeed } * deltaTime;
 
 	// Limit movement to the left half of the screen
 	if (pos.x < 25.0f) {
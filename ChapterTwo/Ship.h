@@ -3,6 +3,7 @@
 
 class Ship : public Actor {
 public:
+	OBJECT_POOL(Ship)
 	Ship(class Game* game);
 	void UpdateActor(float deltaTime) override;
 	void ProcessKeyboard(const uint8_t* state);
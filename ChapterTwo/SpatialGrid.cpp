@@ -0,0 +1,265 @@
+#include "SpatialGrid.h"
+#include "Actor.h"
+#include "SpriteComponent.h"
+#include <algorithm>
+#include <cmath>
+
+SpatialGrid::SpatialGrid(float cellSize, int numBuckets)
+	: mCellSize(cellSize)
+	, mInvCellSize(1.0f / cellSize)
+	, mNumActors(0)
+	, mQueryStamp(0)
+{
+	Rehash(numBuckets);
+}
+
+void SpatialGrid::Add(Actor* actor, const Vector2& halfExtents) {
+	if (actor->mGridProxy >= 0) {
+		SetHalfExtents(actor, halfExtents);
+		return;
+	}
+
+	int index;
+	if (!mFreeProxies.empty()) {
+		index = mFreeProxies.back();
+		mFreeProxies.pop_back();
+	}
+	else {
+		index = static_cast<int>(mProxies.size());
+		mProxies.emplace_back();
+	}
+
+	Proxy& proxy = mProxies[index];
+	proxy.mActor = actor;
+	proxy.mHalfExtents = halfExtents;
+	proxy.mQueryStamp = 0;
+	actor->mGridProxy = index;
+	mNumActors++;
+
+	Vector2 pos = actor->GetPosition();
+	proxy.mMin = pos - halfExtents;
+	proxy.mMax = pos + halfExtents;
+	proxy.mCellMinX = CellCoord(proxy.mMin.x);
+	proxy.mCellMinY = CellCoord(proxy.mMin.y);
+	proxy.mCellMaxX = CellCoord(proxy.mMax.x);
+	proxy.mCellMaxY = CellCoord(proxy.mMax.y);
+	InsertCells(index);
+
+	// Keep buckets to about one actor each
+	if (mNumActors > static_cast<int>(mBuckets.size())) {
+		Rehash(static_cast<int>(mBuckets.size()) * 2);
+	}
+}
+
+void SpatialGrid::Add(Actor* actor, const SpriteComponent* sprite) {
+	float halfScale = actor->GetScale() * 0.5f;
+	Add(actor, Vector2{ sprite->GetTexWidth() * halfScale, sprite->GetTexHeight() * halfScale });
+}
+
+void SpatialGrid::Remove(Actor* actor) {
+	int index = actor->mGridProxy;
+	if (index < 0) {
+		return;
+	}
+
+	RemoveCells(index);
+	mProxies[index].mActor = nullptr;
+	mFreeProxies.emplace_back(index);
+	actor->mGridProxy = -1;
+	mNumActors--;
+}
+
+bool SpatialGrid::Contains(const Actor* actor) const {
+	return actor->mGridProxy >= 0;
+}
+
+void SpatialGrid::SetHalfExtents(Actor* actor, const Vector2& halfExtents) {
+	if (actor->mGridProxy < 0) {
+		return;
+	}
+
+	mProxies[actor->mGridProxy].mHalfExtents = halfExtents;
+	Refresh(actor->mGridProxy);
+}
+
+void SpatialGrid::Update(Actor* actor) {
+	if (actor->mGridProxy >= 0) {
+		Refresh(actor->mGridProxy);
+	}
+}
+
+void SpatialGrid::UpdateAll() {
+	for (int i = 0; i < static_cast<int>(mProxies.size()); i++) {
+		if (mProxies[i].mActor) {
+			Refresh(i);
+		}
+	}
+}
+
+void SpatialGrid::QueryRange(const Vector2& min, const Vector2& max, std::vector<Actor*>& out) {
+	uint32_t stamp = NextQueryStamp();
+
+	int cellMaxX = CellCoord(max.x);
+	int cellMaxY = CellCoord(max.y);
+	for (int cy = CellCoord(min.y); cy <= cellMaxY; cy++) {
+		for (int cx = CellCoord(min.x); cx <= cellMaxX; cx++) {
+			for (int index : GetBucket(cx, cy)) {
+				Proxy& proxy = mProxies[index];
+				if (proxy.mQueryStamp == stamp) {
+					continue;
+				}
+				proxy.mQueryStamp = stamp;
+
+				if (proxy.mMin.x <= max.x && proxy.mMax.x >= min.x
+					&& proxy.mMin.y <= max.y && proxy.mMax.y >= min.y)
+				{
+					out.emplace_back(proxy.mActor);
+				}
+			}
+		}
+	}
+}
+
+void SpatialGrid::QueryRadius(const Vector2& center, float radius, std::vector<Actor*>& out) {
+	uint32_t stamp = NextQueryStamp();
+	float radiusSq = radius * radius;
+
+	int cellMaxX = CellCoord(center.x + radius);
+	int cellMaxY = CellCoord(center.y + radius);
+	for (int cy = CellCoord(center.y - radius); cy <= cellMaxY; cy++) {
+		for (int cx = CellCoord(center.x - radius); cx <= cellMaxX; cx++) {
+			for (int index : GetBucket(cx, cy)) {
+				Proxy& proxy = mProxies[index];
+				if (proxy.mQueryStamp == stamp) {
+					continue;
+				}
+				proxy.mQueryStamp = stamp;
+
+				// Distance from the center to the closest point on the box
+				float dx = center.x - Math::Clamp(center.x, proxy.mMin.x, proxy.mMax.x);
+				float dy = center.y - Math::Clamp(center.y, proxy.mMin.y, proxy.mMax.y);
+				if (dx * dx + dy * dy <= radiusSq) {
+					out.emplace_back(proxy.mActor);
+				}
+			}
+		}
+	}
+}
+
+void SpatialGrid::QueryPairs(std::vector<std::pair<Actor*, Actor*>>& out) {
+	for (int a = 0; a < static_cast<int>(mProxies.size()); a++) {
+		const Proxy& first = mProxies[a];
+		if (!first.mActor) {
+			continue;
+		}
+
+		// Pairs are reported by the lower index, once even when the
+		// boxes share several cells
+		uint32_t stamp = NextQueryStamp();
+		for (int cy = first.mCellMinY; cy <= first.mCellMaxY; cy++) {
+			for (int cx = first.mCellMinX; cx <= first.mCellMaxX; cx++) {
+				for (int b : GetBucket(cx, cy)) {
+					Proxy& second = mProxies[b];
+					if (b <= a || second.mQueryStamp == stamp) {
+						continue;
+					}
+					second.mQueryStamp = stamp;
+
+					if (first.mMin.x <= second.mMax.x && first.mMax.x >= second.mMin.x
+						&& first.mMin.y <= second.mMax.y && first.mMax.y >= second.mMin.y)
+					{
+						out.emplace_back(first.mActor, second.mActor);
+					}
+				}
+			}
+		}
+	}
+}
+
+void SpatialGrid::Refresh(int index) {
+	Proxy& proxy = mProxies[index];
+	Vector2 pos = proxy.mActor->GetPosition();
+	proxy.mMin = pos - proxy.mHalfExtents;
+	proxy.mMax = pos + proxy.mHalfExtents;
+
+	int minX = CellCoord(proxy.mMin.x);
+	int minY = CellCoord(proxy.mMin.y);
+	int maxX = CellCoord(proxy.mMax.x);
+	int maxY = CellCoord(proxy.mMax.y);
+
+	// Most frames an actor stays inside the same cells
+	if (minX == proxy.mCellMinX && minY == proxy.mCellMinY
+		&& maxX == proxy.mCellMaxX && maxY == proxy.mCellMaxY)
+	{
+		return;
+	}
+
+	RemoveCells(index);
+	proxy.mCellMinX = minX;
+	proxy.mCellMinY = minY;
+	proxy.mCellMaxX = maxX;
+	proxy.mCellMaxY = maxY;
+	InsertCells(index);
+}
+
+void SpatialGrid::InsertCells(int index) {
+	const Proxy& proxy = mProxies[index];
+	for (int cy = proxy.mCellMinY; cy <= proxy.mCellMaxY; cy++) {
+		for (int cx = proxy.mCellMinX; cx <= proxy.mCellMaxX; cx++) {
+			GetBucket(cx, cy).emplace_back(index);
+		}
+	}
+}
+
+void SpatialGrid::RemoveCells(int index) {
+	const Proxy& proxy = mProxies[index];
+	for (int cy = proxy.mCellMinY; cy <= proxy.mCellMaxY; cy++) {
+		for (int cx = proxy.mCellMinX; cx <= proxy.mCellMaxX; cx++) {
+			// Buckets are short, swap with the last entry and pop
+			// (Two of the cells may share a bucket, each pass removes one entry)
+			std::vector<int>& bucket = GetBucket(cx, cy);
+			auto iter = std::find(bucket.begin(), bucket.end(), index);
+			if (iter != bucket.end()) {
+				*iter = bucket.back();
+				bucket.pop_back();
+			}
+		}
+	}
+}
+
+void SpatialGrid::Rehash(int numBuckets) {
+	int buckets = 1;
+	while (buckets < numBuckets) {
+		buckets *= 2;
+	}
+
+	mBuckets.clear();
+	mBuckets.resize(buckets);
+	mBucketMask = buckets - 1;
+
+	for (int i = 0; i < static_cast<int>(mProxies.size()); i++) {
+		if (mProxies[i].mActor) {
+			InsertCells(i);
+		}
+	}
+}
+
+std::vector<int>& SpatialGrid::GetBucket(int cellX, int cellY) {
+	uint32_t hash = static_cast<uint32_t>(cellX) * 73856093u ^ static_cast<uint32_t>(cellY) * 19349663u;
+	return mBuckets[hash & mBucketMask];
+}
+
+int SpatialGrid::CellCoord(float value) const {
+	return static_cast<int>(std::floor(value * mInvCellSize));
+}
+
+uint32_t SpatialGrid::NextQueryStamp() {
+	mQueryStamp++;
+	if (mQueryStamp == 0) {
+		for (auto& proxy : mProxies) {
+			proxy.mQueryStamp = 0;
+		}
+		mQueryStamp = 1;
+	}
+	return mQueryStamp;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include "Math.h"
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Uniform grid over world space for broad phase collision and area queries.
+// Each tracked actor has a box around its position (half extents, usually from
+// its sprite) and is listed in every cell the box touches. Cells are hashed into
+// a fixed number of buckets, so the world has no bounds and empty space is free.
+// Update only touches buckets when an actor's box crosses into other cells.
+// Main thread only.
+class SpatialGrid
+{
+public:
+	// cellSize is in world units, roughly the size of the larger actors works well
+	// (numBuckets is rounded up to a power of two, and doubles whenever there
+	// are more actors than buckets)
+	SpatialGrid(float cellSize = 128.0f, int numBuckets = 4096);
+
+	// Start tracking an actor with a box of halfExtents around its position
+	void Add(class Actor* actor, const Vector2& halfExtents);
+	// Box from the sprite's texture size and the actor's scale
+	void Add(class Actor* actor, const class SpriteComponent* sprite);
+	void Remove(class Actor* actor);
+	bool Contains(const class Actor* actor) const;
+	void SetHalfExtents(class Actor* actor, const Vector2& halfExtents);
+
+	// Pick up a tracked actor's new position
+	void Update(class Actor* actor);
+	// Same for every tracked actor (once a frame after actors have moved)
+	void UpdateAll();
+
+	// Queries append to out, each actor at most once
+	// Actors whose boxes overlap the box from min to max
+	void QueryRange(const Vector2& min, const Vector2& max, std::vector<class Actor*>& out);
+	// Actors whose boxes overlap the circle
+	void QueryRadius(const Vector2& center, float radius, std::vector<class Actor*>& out);
+	// Every pair of actors whose boxes overlap, each pair once
+	void QueryPairs(std::vector<std::pair<class Actor*, class Actor*>>& out);
+
+	int GetNumActors() const { return mNumActors; };
+	float GetCellSize() const { return mCellSize; };
+
+private:
+	struct Proxy {
+		// nullptr while on the free list
+		class Actor* mActor;
+		Vector2 mHalfExtents;
+		// World space box as of the last update
+		Vector2 mMin;
+		Vector2 mMax;
+		// Range of cells the box covers (inclusive)
+		int mCellMinX;
+		int mCellMinY;
+		int mCellMaxX;
+		int mCellMaxY;
+		// Last query that visited it (to skip duplicates)
+		uint32_t mQueryStamp;
+	};
+
+	// Recompute the box and move between buckets if the cells changed
+	void Refresh(int index);
+	void InsertCells(int index);
+	void RemoveCells(int index);
+	// Rebuild the buckets with a new bucket count
+	void Rehash(int numBuckets);
+	std::vector<int>& GetBucket(int cellX, int cellY);
+	int CellCoord(float value) const;
+	// New stamp for a query (clears old stamps when it wraps)
+	uint32_t NextQueryStamp();
+
+	float mCellSize;
+	float mInvCellSize;
+	// Indices into mProxies for every cell hashed to the bucket
+	std::vector<std::vector<int>> mBuckets;
+	int mBucketMask;
+
+	std::vector<Proxy> mProxies;
+	std::vector<int> mFreeProxies;
+	int mNumActors;
+	uint32_t mQueryStamp;
+};
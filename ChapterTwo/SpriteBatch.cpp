@@ -0,0 +1,167 @@
+#include "SpriteBatch.h"
+#include "Math.h"
+
+SpriteBatch::SpriteBatch()
+	: mRenderer(nullptr)
+	, mTexture(nullptr)
+	, mTexWidth(0.0f)
+	, mTexHeight(0.0f)
+	, mFrameStats{}
+	, mTotalStats{}
+{}
+
+void SpriteBatch::Begin() {
+	mQueue.clear();
+	mTexture = nullptr;
+	mFrameStats = Stats{};
+}
+
+void SpriteBatch::Draw(const TextureHandle& texture, const SDL_Rect& dest, float rotation) {
+	if (rotation == 0.0f) {
+		Draw(texture, dest, 0.0f, 1.0f, 0.0f);
+	}
+	else {
+		Draw(texture, dest, rotation, Math::Cos(rotation), Math::Sin(rotation));
+	}
+}
+
+void SpriteBatch::Draw(const TextureHandle& texture, const SDL_Rect& dest, float rotation, float cos, float sin) {
+	SDL_Texture* tex = texture.Get();
+	if (!tex) {
+		return;
+	}
+
+	// A new texture ends the current run
+	if (tex != mTexture) {
+		Flush();
+		mTexture = tex;
+		mTexWidth = static_cast<float>(texture.GetTextureWidth());
+		mTexHeight = static_cast<float>(texture.GetTextureHeight());
+	}
+
+	mQueue.emplace_back(QueuedSprite{ *texture.GetSrcRect(), dest, rotation, cos, sin });
+}
+
+void SpriteBatch::Draw(const TextureHandle& texture, const SDL_Rect& src, const SDL_Rect& dest) {
+	SDL_Texture* tex = texture.Get();
+	if (!tex) {
+		return;
+	}
+
+	if (tex != mTexture) {
+		Flush();
+		mTexture = tex;
+		mTexWidth = static_cast<float>(texture.GetTextureWidth());
+		mTexHeight = static_cast<float>(texture.GetTextureHeight());
+	}
+
+	// Offset into the texture's area (sub-textures sit somewhere on an atlas page)
+	const SDL_Rect* area = texture.GetSrcRect();
+	SDL_Rect pageSrc{ area->x + src.x, area->y + src.y, src.w, src.h };
+	mQueue.emplace_back(QueuedSprite{ pageSrc, dest, 0.0f, 1.0f, 0.0f });
+}
+
+void SpriteBatch::Flush() {
+	if (mQueue.empty()) {
+		return;
+	}
+
+	int numSprites = static_cast<int>(mQueue.size());
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	// Build four vertices per sprite in one pass
+	mVertices.resize(numSprites * 4);
+	SDL_Vertex* v = mVertices.data();
+	const SDL_Color white{ 255, 255, 255, 255 };
+	float invW = 1.0f / mTexWidth;
+	float invH = 1.0f / mTexHeight;
+
+	for (const QueuedSprite& sprite : mQueue) {
+		float halfW = sprite.mDest.w * 0.5f;
+		float halfH = sprite.mDest.h * 0.5f;
+		float cx = sprite.mDest.x + halfW;
+		float cy = sprite.mDest.y + halfH;
+
+		// Corners relative to the center (y down), rotated the same way
+		// SDL_RenderCopyEx does with an angle of -rotation
+		float c = sprite.mCos;
+		float s = sprite.mSin;
+		const float cornersX[4] = { -halfW, halfW, halfW, -halfW };
+		const float cornersY[4] = { -halfH, -halfH, halfH, halfH };
+
+		float u0 = sprite.mSrc.x * invW;
+		float v0 = sprite.mSrc.y * invH;
+		float u1 = (sprite.mSrc.x + sprite.mSrc.w) * invW;
+		float v1 = (sprite.mSrc.y + sprite.mSrc.h) * invH;
+		const float us[4] = { u0, u1, u1, u0 };
+		const float vs[4] = { v0, v0, v1, v1 };
+
+		for (int i = 0; i < 4; i++) {
+			v->position.x = cx + cornersX[i] * c + cornersY[i] * s;
+			v->position.y = cy - cornersX[i] * s + cornersY[i] * c;
+			v->color = white;
+			v->tex_coord.x = us[i];
+			v->tex_coord.y = vs[i];
+			v++;
+		}
+	}
+
+	// Two triangles per quad, the pattern never changes so only extend it
+	int numIndices = numSprites * 6;
+	for (int quad = static_cast<int>(mIndices.size()) / 6; quad < numSprites; quad++) {
+		int base = quad * 4;
+		mIndices.insert(mIndices.end(), { base, base + 1, base + 2, base + 2, base + 3, base });
+	}
+
+	SDL_RenderGeometry(
+		mRenderer,
+		mTexture,
+		mVertices.data(),
+		numSprites * 4,
+		mIndices.data(),
+		numIndices
+	);
+
+	mFrameStats.mDrawCalls++;
+	mFrameStats.mVertices += numSprites * 4;
+	mTotalStats.mDrawCalls++;
+	mTotalStats.mVertices += numSprites * 4;
+#else
+	// SDL before 2.0.18 has no geometry API, draw one at a time
+	for (const QueuedSprite& sprite : mQueue) {
+		SDL_RenderCopyEx(
+			mRenderer,
+			mTexture,
+			&sprite.mSrc,
+			&sprite.mDest,
+			-Math::ToDegrees(sprite.mRotation),
+			nullptr,
+			SDL_FLIP_NONE
+		);
+	}
+
+	mFrameStats.mDrawCalls += numSprites;
+	mTotalStats.mDrawCalls += numSprites;
+#endif
+
+	mFrameStats.mSprites += numSprites;
+	mTotalStats.mSprites += numSprites;
+	mQueue.clear();
+}
+
+void SpriteBatch::End() {
+	Flush();
+	mTexture = nullptr;
+}
+
+void SpriteBatch::LogStats(int numFrames) const {
+	if (numFrames <= 0 || mTotalStats.mSprites == 0) {
+		return;
+	}
+
+	SDL_Log("SpriteBatch: per frame %.1f sprites, %.1f draw calls, %.1f vertices",
+		static_cast<double>(mTotalStats.mSprites) / numFrames,
+		static_cast<double>(mTotalStats.mDrawCalls) / numFrames,
+		static_cast<double>(mTotalStats.mVertices) / numFrames
+	);
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "SDL.h"
+#include "TextureCache.h"
+#include <vector>
+
+// Collects sprite draws and submits every run of sprites that share a texture
+// with a single SDL_RenderGeometry call.
+// Sprites are flushed whenever the texture changes, so draw order is kept.
+class SpriteBatch
+{
+public:
+	SpriteBatch();
+
+	void SetRenderer(SDL_Renderer* renderer) { mRenderer = renderer; };
+	SDL_Renderer* GetRenderer() const { return mRenderer; };
+
+	// Start a frame (resets the per-frame stats)
+	void Begin();
+	// Queue a sprite, rotation is in radians (counter-clockwise) about the rect's center
+	void Draw(const TextureHandle& texture, const SDL_Rect& dest, float rotation = 0.0f);
+	// Same with the rotation's cos/sin already worked out (e.g. an actor's cached transform)
+	void Draw(const TextureHandle& texture, const SDL_Rect& dest, float rotation, float cos, float sin);
+	// Queue part of a texture (src is relative to the texture's own area, e.g. one tile of a tile set)
+	void Draw(const TextureHandle& texture, const SDL_Rect& src, const SDL_Rect& dest);
+	// Submit everything queued so far
+	// (Call before drawing straight to the renderer)
+	void Flush();
+	// Flush and finish the frame
+	void End();
+
+	struct Stats {
+		int mDrawCalls;
+		int mSprites;
+		int mVertices;
+	};
+
+	// Stats for the last frame and totals since startup
+	const Stats& GetFrameStats() const { return mFrameStats; };
+	const Stats& GetTotalStats() const { return mTotalStats; };
+	void LogStats(int numFrames) const;
+
+private:
+	struct QueuedSprite {
+		SDL_Rect mSrc;
+		SDL_Rect mDest;
+		float mRotation;
+		float mCos;
+		float mSin;
+	};
+
+	SDL_Renderer* mRenderer;
+
+	// Texture for the sprites currently queued
+	SDL_Texture* mTexture;
+	// Size of the whole texture (for texture coordinates)
+	float mTexWidth;
+	float mTexHeight;
+	std::vector<QueuedSprite> mQueue;
+
+	// Rebuilt each flush, kept around to avoid reallocating
+	std::vector<SDL_Vertex> mVertices;
+	// Fixed quad pattern, only grows
+	std::vector<int> mIndices;
+
+	Stats mFrameStats;
+	Stats mTotalStats;
+};
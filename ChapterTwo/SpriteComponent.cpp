@@ -1,13 +1,22 @@
 #include "SpriteComponent.h"
 #include "Actor.h"
 #include "Game.h"
+#include "SpriteBatch.h"
+#include "Profiler.h"
+#include "Camera.h"
+#include <cmath>
 
 SpriteComponent::SpriteComponent(Actor* owner, int drawOrder)
 	: Component(owner)
-	, mTexture(nullptr)
 	, mDrawOrder(drawOrder)
-	, mTexWidth(0)
-	, mTexHeight(0)
+	, mDrawSlot(-1)
+	, mDrawLayer(nullptr)
+	, mDrawSequence(0)
+	, mDestRect{ 0, 0, 0, 0 }
+	, mBounds{ 0, 0, 0, 0 }
+	, mRectVersion(~0u)
+	, mRectTexWidth(0)
+	, mRectTexHeight(0)
 {
 	mOwner->GetGame()->AddSprite(this);
 }
@@ -16,31 +25,68 @@ SpriteComponent::~SpriteComponent() {
 	mOwner->GetGame()->RemoveSprite(this);
 }
 
-void SpriteComponent::Draw(SDL_Renderer* mRenderer) {
+void SpriteComponent::Draw(SpriteBatch* batch) {
+	PROFILE_SCOPE("SpriteComponent::Draw");
 	if (mTexture) {
-		SDL_Rect r;
-		// Scale width/height by owner's scale
-		r.w = static_cast<int>(mTexWidth * mOwner->GetScale());
-		r.h = static_cast<int>(mTexHeight * mOwner->GetScale());
-		// Center the rectangle around the position of the owner
-		r.x = static_cast<int>(mOwner->GetPosition().x - r.w / 2);
-		r.y = static_cast<int>(mOwner->GetPosition().y - r.h / 2);
-
-		// Draw
-		SDL_RenderCopyEx(
-			mRenderer,		// Renderer
-			mTexture,		// Texture to draw
-			nullptr,		// Source rectangle
-			&r,				// Destination rectangle
-			-Math::ToDegrees(mOwner->GetRotation()),		// (Convert angle)
-			nullptr,		// Point of rotation
-			SDL_FLIP_NONE	// Flip behaviour	
-		);
+		UpdateRect();
+		SDL_Rect dest = mOwner->GetGame()->GetCamera()->WorldToScreen(mDestRect);
+
+		// Draw (batched with neighbouring sprites on the same texture)
+		batch->Draw(mTexture, dest, mOwner->GetDrawRotation(), mOwner->GetDrawCos(), mOwner->GetDrawSin());
+	}
+}
+
+bool SpriteComponent::Cull(Camera* camera) {
+	// Nothing to draw yet, Draw skips it anyway
+	if (!mTexture) {
+		return false;
+	}
+	return !camera->Submit(GetBounds());
+}
+
+void SpriteComponent::UpdateRect() {
+	// Static sprites skip all of this after the first frame
+	int texWidth = mTexture.GetWidth();
+	int texHeight = mTexture.GetHeight();
+	unsigned version = mOwner->GetTransformVersion();
+	if (version == mRectVersion && texWidth == mRectTexWidth && texHeight == mRectTexHeight) {
+		return;
 	}
+	mRectVersion = version;
+	mRectTexWidth = texWidth;
+	mRectTexHeight = texHeight;
+
+	SDL_Rect& r = mDestRect;
+	// Scale width/height by owner's scale
+	r.w = static_cast<int>(texWidth * mOwner->GetScale());
+	r.h = static_cast<int>(texHeight * mOwner->GetScale());
+	// Center the rectangle around the position of the owner
+	// (interpolated between simulation steps)
+	const Vector2& pos = mOwner->GetDrawPosition();
+	r.x = static_cast<int>(pos.x - r.w / 2);
+	r.y = static_cast<int>(pos.y - r.h / 2);
+
+	// Box around the rect rotated about its center
+	float c = Math::Abs(mOwner->GetDrawCos());
+	float s = Math::Abs(mOwner->GetDrawSin());
+	int w = static_cast<int>(std::ceil(r.w * c + r.h * s));
+	int h = static_cast<int>(std::ceil(r.w * s + r.h * c));
+	mBounds = SDL_Rect{ r.x + (r.w - w) / 2, r.y + (r.h - h) / 2, w, h };
+}
+
+void SpriteComponent::SetDrawOrder(int drawOrder) {
+	if (drawOrder == mDrawOrder) {
+		return;
+	}
+
+	// The layer is found by draw order, so leave before changing it
+	Game* game = mOwner->GetGame();
+	game->RemoveSprite(this);
+	mDrawOrder = drawOrder;
+	game->AddSprite(this);
 }
 
-void SpriteComponent::SetTexture(SDL_Texture* texture) {
-	mTexture = texture;
-	// Get width / height of texture
-	SDL_QueryTexture(texture, nullptr, nullptr, &mTexWidth, &mTexHeight);
+void SpriteComponent::SetTexture(const TextureHandle& texture) {
+	// Width / height are already known by the cache, no need to query
+	ChangeTexture(texture);
 }
\ No newline at end of file
@@ -1,27 +1,65 @@
 #pragma once
 #include "Component.h"
 #include "SDL.h"
+#include "TextureCache.h"
+#include "DrawList.h"
 
 class SpriteComponent : public Component 
 {
 public:
+	OBJECT_POOL(SpriteComponent)
 	// (Lower draw order corresponds with further back)
 	SpriteComponent(class Actor* owner, int drawOrder = 100);
 	~SpriteComponent();
 
-	virtual void Draw(SDL_Renderer* renderer);
-	virtual void SetTexture(SDL_Texture* texture);
+	// Queue this sprite's draw on the batch (in the camera's screen space)
+	virtual void Draw(class SpriteBatch* batch);
+	// Nothing of the sprite is in the camera's view, skip drawing it
+	// (Counts it with the camera; sprites that cull their own pieces override this)
+	virtual bool Cull(class Camera* camera);
+	virtual void SetTexture(const TextureHandle& texture);
 
 	int GetDrawOrder() const { return mDrawOrder; }
-	int GetTexHeight() const { return mTexHeight; }
-	int GetTexWidth() const { return mTexWidth; }
+	// Moves the sprite to another layer of the draw list
+	void SetDrawOrder(int drawOrder);
+	// Texture id the draw list groups by (atlas sprites share their page's)
+	uint32_t GetSortId() const { return mTexture.GetBatchId(); }
+	int GetTexHeight() const { return mTexture.GetHeight(); }
+	int GetTexWidth() const { return mTexture.GetWidth(); }
+
+	// Screen rect the sprite is drawn to and the box around it once rotated
+	// (Cached, only rebuilt when the owner's transform or the texture size changes)
+	const SDL_Rect& GetDestRect() { UpdateRect(); return mDestRect; }
+	const SDL_Rect& GetBounds() { UpdateRect(); return mBounds; }
 
 protected:
-	// Texture to draw
-	SDL_Texture* mTexture;
+	// Rebuild the cached rects if they're out of date
+	void UpdateRect();
+	// Swap the texture, flagging the layer for a re-sort if it batches differently
+	void ChangeTexture(const TextureHandle& texture) {
+		if (mDrawLayer && texture.GetBatchId() != mTexture.GetBatchId()) {
+			mDrawLayer->mDirty.store(true, std::memory_order_relaxed);
+		}
+		mTexture = texture;
+	}
+
+	// DrawList tracks where the sprite sits in its layer
+	friend class DrawList;
+
+	// Texture to draw (width/height come from the cache entry)
+	TextureHandle mTexture;
 	// Draw order used for painter's algorithm
 	int mDrawOrder;
-	// Width/Height of texture
-	int mTexHeight;
-	int mTexWidth;
+	// Index in the draw list layer, -1 when not in one
+	int mDrawSlot;
+	// Layer it's in (nullptr when not in one) and when it was added
+	DrawList::Layer* mDrawLayer;
+	unsigned mDrawSequence;
+
+	// Cached rects, and the owner's transform version / texture size they're for
+	SDL_Rect mDestRect;
+	SDL_Rect mBounds;
+	unsigned mRectVersion;
+	int mRectTexWidth;
+	int mRectTexHeight;
 };
@@ -0,0 +1,66 @@
+#include "TextureAtlas.h"
+#include "Math.h"
+#include <algorithm>
+
+TextureAtlas::TextureAtlas(int pageSize, int padding)
+	: mPageSize(pageSize)
+	, mPadding(padding)
+{}
+
+void TextureAtlas::Pack(const std::vector<SDL_Point>& sizes) {
+	mPlacements.assign(sizes.size(), Placement{ -1, SDL_Rect{ 0, 0, 0, 0 } });
+	mPages.clear();
+
+	// Tallest first keeps the shelves tight
+	std::vector<int> order(sizes.size());
+	for (size_t i = 0; i < order.size(); i++) {
+		order[i] = static_cast<int>(i);
+	}
+	std::stable_sort(order.begin(), order.end(), [&sizes](int a, int b) {
+		return sizes[a].y > sizes[b].y;
+	});
+
+	int x = 0;
+	int y = 0;
+	int shelfHeight = 0;
+
+	for (int index : order) {
+		int w = sizes[index].x;
+		int h = sizes[index].y;
+
+		// Doesn't fit on any page, caller keeps it as its own texture
+		if (w > mPageSize || h > mPageSize) {
+			continue;
+		}
+
+		if (mPages.empty()) {
+			mPages.emplace_back(Page{ 0, 0 });
+		}
+
+		// Start a new shelf when the row is full
+		if (x + w > mPageSize) {
+			x = 0;
+			y += shelfHeight + mPadding;
+			shelfHeight = 0;
+		}
+
+		// Start a new page when the shelves are full
+		if (y + h > mPageSize) {
+			mPages.emplace_back(Page{ 0, 0 });
+			x = 0;
+			y = 0;
+			shelfHeight = 0;
+		}
+
+		Placement& place = mPlacements[index];
+		place.mPage = static_cast<int>(mPages.size()) - 1;
+		place.mRect = SDL_Rect{ x, y, w, h };
+
+		Page& page = mPages.back();
+		page.mWidth = Math::Max(page.mWidth, x + w);
+		page.mHeight = Math::Max(page.mHeight, y + h);
+
+		x += w + mPadding;
+		shelfHeight = Math::Max(shelfHeight, h);
+	}
+}
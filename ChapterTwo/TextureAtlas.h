@@ -0,0 +1,37 @@
+#pragma once
+#include "SDL.h"
+#include <vector>
+
+// Shelf packer used to build texture atlases.
+// Rectangles are packed tallest first into rows ("shelves") across one or more
+// square pages; each page is trimmed to the area actually used.
+class TextureAtlas
+{
+public:
+	struct Placement {
+		// Which page the rectangle went on (-1 if it's bigger than a page)
+		int mPage;
+		// Position and size on that page
+		SDL_Rect mRect;
+	};
+
+	struct Page {
+		int mWidth;
+		int mHeight;
+	};
+
+	// pageSize is the largest page width/height, padding is left between rects
+	TextureAtlas(int pageSize = 2048, int padding = 1);
+
+	// Pack rectangles of the given sizes, placements are in the same order
+	void Pack(const std::vector<SDL_Point>& sizes);
+
+	const std::vector<Placement>& GetPlacements() const { return mPlacements; };
+	const std::vector<Page>& GetPages() const { return mPages; };
+
+private:
+	int mPageSize;
+	int mPadding;
+	std::vector<Placement> mPlacements;
+	std::vector<Page> mPages;
+};
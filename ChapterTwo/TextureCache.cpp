@@ -0,0 +1,667 @@
+#include "TextureCache.h"
+#include "TextureAtlas.h"
+#include "SDL_image.h"
+#include "Math.h"
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+	double SecondsSince(Uint64 start) {
+		return static_cast<double>(SDL_GetPerformanceCounter() - start)
+			/ SDL_GetPerformanceFrequency();
+	}
+}
+
+TextureCache::TextureCache()
+	: mRenderer(nullptr)
+	, mPremultipliedSupported(false)
+	, mPremultipliedBlend(SDL_BLENDMODE_BLEND)
+	, mNextId(1)
+	, mBudget(256 * 1024 * 1024)
+	, mStats{}
+{}
+
+TextureCache::~TextureCache() {
+	Clear();
+}
+
+void TextureCache::SetRenderer(SDL_Renderer* renderer) {
+	mRenderer = renderer;
+
+	// src + dst * (1 - srcAlpha), for textures with premultiplied alpha
+	mPremultipliedBlend = SDL_ComposeCustomBlendMode(
+		SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+		SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD
+	);
+
+	// Not every renderer can do custom blend modes (the software one can't)
+	mPremultipliedSupported = false;
+	if (mRenderer) {
+		SDL_Texture* test = SDL_CreateTexture(mRenderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, 1, 1);
+		mPremultipliedSupported = test && SDL_SetTextureBlendMode(test, mPremultipliedBlend) == 0;
+		SDL_DestroyTexture(test);
+	}
+}
+
+bool TextureCache::MountBundle(const std::string& fileName) {
+	if (!mBundle.Open(fileName)) {
+		return false;
+	}
+
+	SDL_Log("Mounted asset bundle %s (%d images)", fileName.c_str(), mBundle.GetNumImages());
+	return true;
+}
+
+void TextureCache::UnmountBundle() {
+	// Uploaded textures have their own copy of the pixels
+	mBundle.Close();
+}
+
+void TextureCache::SetBudget(size_t bytes) {
+	mBudget = bytes;
+	EvictToBudget();
+}
+
+TextureHandle TextureCache::Load(const std::string& fileName) {
+	// Is the texture already resident (or on its way)?
+	auto iter = mEntries.find(fileName);
+
+	if (iter != mEntries.end() && iter->second->mPending) {
+		// Queued by LoadAsync, but this caller needs it now
+		// (if the decode failed the entry is gone and this tries again below)
+		FinishLoads();
+		iter = mEntries.find(fileName);
+	}
+
+	if (iter != mEntries.end()) {
+		mStats.mHits++;
+		return TextureHandle(iter->second);
+	}
+
+	mStats.mMisses++;
+
+	// Already decoded in the bundle?
+	AssetBundle::Image image;
+	if (mBundle.Find(fileName, image)) {
+		Entry* entry = CreateEntry(fileName);
+		if (!UploadImage(entry, image)) {
+			Destroy(entry);
+			return TextureHandle();
+		}
+
+		mStats.mBundleLoads++;
+		return TextureHandle(entry);
+	}
+
+	// Load from file
+	Uint64 start = SDL_GetPerformanceCounter();
+	SDL_Surface* surf = IMG_Load(fileName.c_str());
+	mStats.mDecodeTime += SecondsSince(start);
+
+	if (!surf) {
+		SDL_Log("Failed to load texture file: %s", fileName.c_str());
+		return TextureHandle();
+	}
+
+	Entry* entry = CreateEntry(fileName);
+	if (!Upload(entry, surf)) {
+		Destroy(entry);
+		return TextureHandle();
+	}
+
+	return TextureHandle(entry);
+}
+
+TextureHandle TextureCache::LoadAsync(const std::string& fileName) {
+	auto iter = mEntries.find(fileName);
+
+	if (iter != mEntries.end()) {
+		mStats.mHits++;
+		return TextureHandle(iter->second);
+	}
+
+	// Nothing to decode for bundled images, the upload may as well happen now
+	AssetBundle::Image image;
+	if (mBundle.Find(fileName, image)) {
+		return Load(fileName);
+	}
+
+	mStats.mMisses++;
+	mStats.mAsyncLoads++;
+
+	// The entry exists straight away so repeat requests share it,
+	// the loader's reference keeps it alive until the upload
+	Entry* entry = CreateEntry(fileName);
+	entry->mPending = true;
+	AddRef(entry);
+
+	mLoader.QueueImage(fileName);
+
+	return TextureHandle(entry);
+}
+
+void TextureCache::StartLoader(int numThreads) {
+	mLoader.Start(numThreads);
+}
+
+void TextureCache::StopLoader() {
+	mLoader.WaitForAll();
+	ProcessUploads();
+	mLoader.Shutdown();
+}
+
+void TextureCache::ProcessUploads() {
+	mLoader.CollectFinished(mDecoded);
+
+	for (auto& image : mDecoded) {
+		UploadDecoded(image);
+	}
+	mDecoded.clear();
+
+	// Textures released since last frame may have to go
+	EvictToBudget();
+}
+
+void TextureCache::UploadDecoded(AssetLoader::DecodedImage& image) {
+	mStats.mDecodeTime += image.mDecodeTime;
+
+	Entry* entry = mEntries[image.mFileName];
+	entry->mPending = false;
+
+	if (!image.mSurface || !Upload(entry, image.mSurface)) {
+		// Don't let later loads hit a texture that will never arrive. Handles
+		// already given out stay empty, the last of them frees the entry
+		// (same as handles that outlive Clear)
+		mEntries.erase(image.mFileName);
+		mStats.mTexturesResident--;
+		entry->mCache = nullptr;
+		if (--entry->mRefCount == 0) {
+			delete entry;
+		}
+		return;
+	}
+
+	// Drop the loader's reference
+	Release(entry);
+}
+
+void TextureCache::FinishLoads() {
+	mLoader.WaitForAll();
+	ProcessUploads();
+}
+
+void TextureCache::BuildAtlas(const std::vector<std::string>& fileNames, int pageSize) {
+	// Anything already decoded for someone else gets uploaded as normal
+	FinishLoads();
+
+	// With a bundle mounted the pages hold premultiplied pixels
+	bool premultiplied = mBundle.IsOpen();
+
+	std::vector<SDL_Surface*> surfaces;
+	std::vector<SDL_Point> sizes;
+	std::vector<std::string> names;
+
+	// Decode everything not already resident on the loader threads
+	// (Bundled images are already decoded, the mapped pixels are blitted directly)
+	std::vector<std::string> toPack;
+	for (const auto& fileName : fileNames) {
+		if (mEntries.find(fileName) != mEntries.end()
+			|| std::find(toPack.begin(), toPack.end(), fileName) != toPack.end())
+		{
+			continue;
+		}
+		toPack.emplace_back(fileName);
+
+		AssetBundle::Image image;
+		if (mBundle.Find(fileName, image) && image.mPremultiplied) {
+			SDL_Surface* mapped = SDL_CreateRGBSurfaceWithFormatFrom(
+				const_cast<void*>(image.mPixels),
+				image.mWidth,
+				image.mHeight,
+				32,
+				image.mPitch,
+				SDL_PIXELFORMAT_RGBA32
+			);
+
+			if (mapped) {
+				surfaces.emplace_back(mapped);
+				sizes.emplace_back(SDL_Point{ image.mWidth, image.mHeight });
+				names.emplace_back(fileName);
+				mStats.mBundleLoads++;
+				continue;
+			}
+		}
+
+		mLoader.QueueImage(fileName);
+	}
+
+	if (toPack.empty()) {
+		return;
+	}
+
+	mLoader.WaitForAll();
+	mLoader.CollectFinished(mDecoded);
+
+	for (auto& image : mDecoded) {
+		mStats.mDecodeTime += image.mDecodeTime;
+
+		if (!image.mSurface) {
+			continue;
+		}
+
+		// Work in one pixel format so the blits are straight copies
+		SDL_Surface* rgba = SDL_ConvertSurfaceFormat(image.mSurface, SDL_PIXELFORMAT_RGBA32, 0);
+		SDL_FreeSurface(image.mSurface);
+
+		if (!rgba) {
+			SDL_Log("Failed to convert %s for the atlas: %s", image.mFileName.c_str(), SDL_GetError());
+			continue;
+		}
+
+		if (premultiplied) {
+			SDL_LockSurface(rgba);
+			AssetBundle::Premultiply(rgba->pixels, rgba->w, rgba->h, rgba->pitch);
+			SDL_UnlockSurface(rgba);
+		}
+
+		surfaces.emplace_back(rgba);
+		sizes.emplace_back(SDL_Point{ rgba->w, rgba->h });
+		names.emplace_back(image.mFileName);
+	}
+	mDecoded.clear();
+
+	TextureAtlas atlas(pageSize);
+	atlas.Pack(sizes);
+
+	// Build and upload each page
+	std::vector<Entry*> pages;
+	for (size_t p = 0; p < atlas.GetPages().size(); p++) {
+		const TextureAtlas::Page& page = atlas.GetPages()[p];
+		SDL_Surface* pageSurf = SDL_CreateRGBSurfaceWithFormat(
+			0,
+			page.mWidth,
+			page.mHeight,
+			32,
+			SDL_PIXELFORMAT_RGBA32
+		);
+		if (!pageSurf) {
+			// Its frames are uploaded on their own below
+			SDL_Log("Failed to create a %dx%d atlas page: %s", page.mWidth, page.mHeight, SDL_GetError());
+			pages.emplace_back(nullptr);
+			continue;
+		}
+
+		for (size_t i = 0; i < surfaces.size(); i++) {
+			const TextureAtlas::Placement& place = atlas.GetPlacements()[i];
+			if (place.mPage == static_cast<int>(p)) {
+				// Copy alpha as-is rather than blending onto the page
+				SDL_SetSurfaceBlendMode(surfaces[i], SDL_BLENDMODE_NONE);
+				SDL_Rect dest = place.mRect;
+				SDL_BlitSurface(surfaces[i], nullptr, pageSurf, &dest);
+			}
+		}
+
+		Entry* pageEntry = CreateEntry("atlas:" + std::to_string(mStats.mAtlasPages++));
+		if (!Upload(pageEntry, pageSurf, premultiplied)) {
+			Destroy(pageEntry);
+			pageEntry = nullptr;
+		}
+		pages.emplace_back(pageEntry);
+	}
+
+	// Register each image as a rectangle on its page
+	for (size_t i = 0; i < surfaces.size(); i++) {
+		const TextureAtlas::Placement& place = atlas.GetPlacements()[i];
+
+		Entry* entry = CreateEntry(names[i]);
+
+		if (place.mPage < 0 || !pages[place.mPage]) {
+			// Too big for a page (or the page failed), keep it as a standalone texture
+			if (!Upload(entry, surfaces[i], premultiplied)) {
+				Destroy(entry);
+				continue;
+			}
+		}
+		else {
+			Entry* page = pages[place.mPage];
+			entry->mTexture = page->mTexture;
+			entry->mWidth = place.mRect.w;
+			entry->mHeight = place.mRect.h;
+			entry->mSrcRect = place.mRect;
+			entry->mPage = page;
+			AddRef(page);
+			SDL_FreeSurface(surfaces[i]);
+		}
+
+		// Nobody references it until it's loaded, so it starts out
+		// on the unused list like any other idle texture
+		AddRef(entry);
+		Release(entry);
+	}
+}
+
+void TextureCache::Clear() {
+	// Nothing can still be in flight when the entries go
+	FinishLoads();
+
+	// Atlas sub-textures let go of their pages first
+	// (they don't own a texture of their own)
+	for (auto& iter : mEntries) {
+		Entry* entry = iter.second;
+
+		if (entry->mPage) {
+			entry->mPage->mRefCount--;
+			entry->mPage = nullptr;
+			entry->mTexture = nullptr;
+		}
+	}
+
+	for (auto& iter : mEntries) {
+		Entry* entry = iter.second;
+
+		if (entry->mRefCount > 0) {
+			// Still referenced, the last handle frees the entry
+			SDL_Log("Texture still referenced at shutdown: %s", entry->mFileName.c_str());
+			SDL_DestroyTexture(entry->mTexture);
+			entry->mTexture = nullptr;
+			entry->mCache = nullptr;
+		}
+		else {
+			SDL_DestroyTexture(entry->mTexture);
+			delete entry;
+		}
+	}
+
+	mEntries.clear();
+	mUnused.clear();
+	mStats.mBytesResident = 0;
+	mStats.mTexturesResident = 0;
+}
+
+void TextureCache::LogStats() const {
+	SDL_Log("TextureCache: %d hits, %d misses (%d async, %d from bundle), %d evictions, %d atlas pages",
+		mStats.mHits,
+		mStats.mMisses,
+		mStats.mAsyncLoads,
+		mStats.mBundleLoads,
+		mStats.mEvictions,
+		mStats.mAtlasPages
+	);
+	SDL_Log("  decode %.3f ms, upload %.3f ms, %d textures / %zu bytes resident (peak %zu)",
+		mStats.mDecodeTime * 1000.0,
+		mStats.mUploadTime * 1000.0,
+		mStats.mTexturesResident,
+		mStats.mBytesResident,
+		mStats.mPeakBytesResident
+	);
+}
+
+TextureCache::Entry* TextureCache::CreateEntry(const std::string& fileName) {
+	Entry* entry = new Entry();
+	entry->mCache = this;
+	entry->mFileName = fileName;
+	entry->mId = mNextId++;
+	entry->mTexture = nullptr;
+	entry->mWidth = 0;
+	entry->mHeight = 0;
+	entry->mSrcRect = SDL_Rect{ 0, 0, 0, 0 };
+	entry->mPage = nullptr;
+	entry->mBytes = 0;
+	entry->mRefCount = 0;
+	entry->mPending = false;
+	entry->mUnused = false;
+
+	mEntries.emplace(fileName, entry);
+	mStats.mTexturesResident++;
+
+	return entry;
+}
+
+bool TextureCache::Upload(Entry* entry, SDL_Surface* surf, bool premultiplied) {
+	if (premultiplied && !mPremultipliedSupported) {
+		// Back to straight alpha on a copy (surf may be wrapping the bundle's read only pixels)
+		SDL_Surface* straight = SDL_ConvertSurfaceFormat(surf, SDL_PIXELFORMAT_RGBA32, 0);
+		SDL_FreeSurface(surf);
+		if (!straight) {
+			SDL_Log("Failed to convert surface for: %s", entry->mFileName.c_str());
+			return false;
+		}
+
+		SDL_LockSurface(straight);
+		AssetBundle::Unpremultiply(straight->pixels, straight->w, straight->h, straight->pitch);
+		SDL_UnlockSurface(straight);
+		surf = straight;
+		premultiplied = false;
+	}
+
+	// Create texture from surface
+	Uint64 start = SDL_GetPerformanceCounter();
+	SDL_Texture* tex = SDL_CreateTextureFromSurface(mRenderer, surf);
+	mStats.mUploadTime += SecondsSince(start);
+
+	if (!tex) {
+		SDL_Log("Failed to convert surface to texture for: %s", entry->mFileName.c_str());
+		SDL_FreeSurface(surf);
+		return false;
+	}
+
+	if (premultiplied) {
+		SetBlendMode(tex, true);
+	}
+
+	entry->mTexture = tex;
+	entry->mWidth = surf->w;
+	entry->mHeight = surf->h;
+	entry->mSrcRect = SDL_Rect{ 0, 0, surf->w, surf->h };
+	// Size it the way the renderer stores it, paletted and 24 bit images
+	// are expanded on upload (4 bytes per pixel if it won't say)
+	Uint32 format = SDL_PIXELFORMAT_UNKNOWN;
+	int bytesPerPixel = 4;
+	if (SDL_QueryTexture(tex, &format, nullptr, nullptr, nullptr) == 0 && SDL_BYTESPERPIXEL(format) > 0) {
+		bytesPerPixel = SDL_BYTESPERPIXEL(format);
+	}
+	entry->mBytes = static_cast<size_t>(surf->w) * surf->h * bytesPerPixel;
+	SDL_FreeSurface(surf);
+
+	mStats.mBytesResident += entry->mBytes;
+	mStats.mPeakBytesResident = Math::Max(mStats.mPeakBytesResident, mStats.mBytesResident);
+	EvictToBudget();
+
+	return true;
+}
+
+bool TextureCache::UploadImage(Entry* entry, const AssetBundle::Image& image) {
+	Uint64 start = SDL_GetPerformanceCounter();
+
+	SDL_Texture* tex = SDL_CreateTexture(
+		mRenderer,
+		SDL_PIXELFORMAT_RGBA32,
+		SDL_TEXTUREACCESS_STATIC,
+		image.mWidth,
+		image.mHeight
+	);
+
+	if (!tex) {
+		SDL_Log("Failed to create texture for: %s", entry->mFileName.c_str());
+		return false;
+	}
+
+	if (!image.mPremultiplied || mPremultipliedSupported) {
+		// Straight from the mapping, no intermediate surface
+		SDL_UpdateTexture(tex, nullptr, image.mPixels, image.mPitch);
+		SetBlendMode(tex, image.mPremultiplied);
+	}
+	else {
+		// Renderer can't blend premultiplied pixels, undo it on a copy
+		std::vector<uint8_t> straight(static_cast<const uint8_t*>(image.mPixels),
+			static_cast<const uint8_t*>(image.mPixels) + static_cast<size_t>(image.mPitch) * image.mHeight);
+		AssetBundle::Unpremultiply(straight.data(), image.mWidth, image.mHeight, image.mPitch);
+		SDL_UpdateTexture(tex, nullptr, straight.data(), image.mPitch);
+		SetBlendMode(tex, false);
+	}
+
+	mStats.mUploadTime += SecondsSince(start);
+
+	entry->mTexture = tex;
+	entry->mWidth = image.mWidth;
+	entry->mHeight = image.mHeight;
+	entry->mSrcRect = SDL_Rect{ 0, 0, image.mWidth, image.mHeight };
+	entry->mBytes = static_cast<size_t>(image.mWidth) * image.mHeight * 4;
+
+	mStats.mBytesResident += entry->mBytes;
+	mStats.mPeakBytesResident = Math::Max(mStats.mPeakBytesResident, mStats.mBytesResident);
+	EvictToBudget();
+
+	return true;
+}
+
+void TextureCache::SetBlendMode(SDL_Texture* texture, bool premultiplied) {
+	if (premultiplied && mPremultipliedSupported) {
+		SDL_SetTextureBlendMode(texture, mPremultipliedBlend);
+	}
+	else {
+		SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+	}
+}
+
+void TextureCache::AddRef(Entry* entry) {
+	if (entry->mRefCount.fetch_add(1) == 0) {
+		// Referenced again, no longer a candidate for eviction
+		// (Recheck under the lock, a release on another thread may have raced us)
+		std::lock_guard<std::mutex> lock(mUnusedMutex);
+		if (entry->mUnused && entry->mRefCount > 0) {
+			mUnused.erase(entry->mUnusedPos);
+			entry->mUnused = false;
+		}
+	}
+}
+
+void TextureCache::Release(Entry* entry) {
+	// Eviction waits for the main thread (EvictToBudget)
+	if (entry->mRefCount.fetch_sub(1) == 1) {
+		std::lock_guard<std::mutex> lock(mUnusedMutex);
+		MarkUnused(entry);
+	}
+}
+
+void TextureCache::MarkUnused(Entry* entry) {
+	if (entry->mRefCount == 0 && !entry->mUnused) {
+		// Most recently used goes to the back
+		entry->mUnusedPos = mUnused.insert(mUnused.end(), entry);
+		entry->mUnused = true;
+	}
+}
+
+void TextureCache::EvictToBudget() {
+	std::lock_guard<std::mutex> lock(mUnusedMutex);
+
+	while (mStats.mBytesResident > mBudget && !mUnused.empty()) {
+		Entry* entry = mUnused.front();
+		mUnused.pop_front();
+		entry->mUnused = false;
+
+		// Picked up again since it was released
+		if (entry->mRefCount > 0) {
+			continue;
+		}
+
+		mStats.mEvictions++;
+		Destroy(entry);
+	}
+}
+
+void TextureCache::Destroy(Entry* entry) {
+	mEntries.erase(entry->mFileName);
+	mStats.mBytesResident -= entry->mBytes;
+	mStats.mTexturesResident--;
+
+	if (entry->mPage) {
+		// Page texture is shared, just let go of it
+		// (Only called while evicting, which already holds mUnusedMutex)
+		Entry* page = entry->mPage;
+		delete entry;
+		if (page->mRefCount.fetch_sub(1) == 1) {
+			MarkUnused(page);
+		}
+	}
+	else {
+		SDL_DestroyTexture(entry->mTexture);
+		delete entry;
+	}
+}
+
+TextureHandle::TextureHandle(TextureCache::Entry* entry)
+	: mEntry(entry)
+{
+	mEntry->mCache->AddRef(mEntry);
+}
+
+TextureHandle::TextureHandle(const TextureHandle& other)
+	: mEntry(other.mEntry)
+{
+	if (mEntry) {
+		if (mEntry->mCache) {
+			mEntry->mCache->AddRef(mEntry);
+		}
+		else {
+			mEntry->mRefCount++;
+		}
+	}
+}
+
+TextureHandle::TextureHandle(TextureHandle&& other) noexcept
+	: mEntry(other.mEntry)
+{
+	other.mEntry = nullptr;
+}
+
+TextureHandle& TextureHandle::operator=(const TextureHandle& other) {
+	if (mEntry != other.mEntry) {
+		TextureHandle temp(other);
+		*this = std::move(temp);
+	}
+	return *this;
+}
+
+TextureHandle& TextureHandle::operator=(TextureHandle&& other) noexcept {
+	if (this != &other) {
+		Reset();
+		mEntry = other.mEntry;
+		other.mEntry = nullptr;
+	}
+	return *this;
+}
+
+int TextureHandle::GetTextureWidth() const {
+	if (!mEntry) {
+		return 0;
+	}
+	return mEntry->mPage ? mEntry->mPage->mWidth : mEntry->mWidth;
+}
+
+int TextureHandle::GetTextureHeight() const {
+	if (!mEntry) {
+		return 0;
+	}
+	return mEntry->mPage ? mEntry->mPage->mHeight : mEntry->mHeight;
+}
+
+TextureHandle::~TextureHandle() {
+	Reset();
+}
+
+void TextureHandle::Reset() {
+	if (!mEntry) {
+		return;
+	}
+
+	if (mEntry->mCache) {
+		mEntry->mCache->Release(mEntry);
+	}
+	else if (--mEntry->mRefCount == 0) {
+		// The cache was cleared while this handle was alive
+		delete mEntry;
+	}
+	mEntry = nullptr;
+}
@@ -0,0 +1,179 @@
+#pragma once
+#include "SDL.h"
+#include "AssetLoader.h"
+#include "AssetBundle.h"
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+class TextureHandle;
+
+// Owns every texture loaded from disk.
+// Textures are handed out as reference counted handles; once nothing references
+// a texture it stays resident (so reloading it is a hit) until the memory budget
+// forces the least recently used ones out.
+// Handles can be copied and dropped from any thread (the reference counts are
+// atomic), everything else on the cache is main thread only.
+class TextureCache
+{
+public:
+	TextureCache();
+	~TextureCache();
+
+	void SetRenderer(SDL_Renderer* renderer);
+	// Bytes of textures allowed to stay resident in total, unreferenced textures
+	// are evicted (least recently used first) until the cache fits or none are left
+	void SetBudget(size_t bytes);
+	size_t GetBudget() const { return mBudget; };
+
+	// Get the texture for a file, loading it if it isn't resident
+	// (waits for the loader if LoadAsync already queued it)
+	TextureHandle Load(const std::string& fileName);
+	// Same as Load but decodes on a loader thread, the handle is empty
+	// until ProcessUploads picks up the decoded image
+	TextureHandle LoadAsync(const std::string& fileName);
+
+	// Start/stop the loader threads used by LoadAsync (0 picks a count)
+	void StartLoader(int numThreads = 0);
+	void StopLoader();
+	// Upload any images the loader has finished decoding (main thread only)
+	void ProcessUploads();
+	// Block until every async load has been decoded and uploaded
+	void FinishLoads();
+
+	// Serve loads from a pre-decoded bundle (see AssetBundle) where it has the file
+	// (anything it doesn't have still loads from disk)
+	bool MountBundle(const std::string& fileName);
+	void UnmountBundle();
+
+	// Pack these images into as few atlas pages as possible
+	// Later loads of the files return a sub-rectangle of a shared page texture
+	// (Files that are already resident are left alone)
+	void BuildAtlas(const std::vector<std::string>& fileNames, int pageSize = 2048);
+
+	// Destroy every texture (any handles still alive end up empty)
+	void Clear();
+
+	// Blend premultiplied textures properly, or fall back to straight alpha
+	// if the renderer can't do custom blend modes
+	// (Render targets drawn into with alpha blending hold premultiplied pixels too)
+	void SetBlendMode(SDL_Texture* texture, bool premultiplied);
+	bool IsPremultipliedSupported() const { return mPremultipliedSupported; };
+
+	struct Stats {
+		int mHits;
+		int mMisses;
+		int mEvictions;
+		int mAsyncLoads;
+		int mAtlasPages;
+		int mBundleLoads;
+		// Time spent in IMG_Load and texture upload (in seconds)
+		// (Decode time is summed over all loader threads)
+		double mDecodeTime;
+		double mUploadTime;
+		size_t mBytesResident;
+		size_t mPeakBytesResident;
+		int mTexturesResident;
+	};
+
+	const Stats& GetStats() const { return mStats; };
+	void LogStats() const;
+
+private:
+	friend class TextureHandle;
+
+	struct Entry {
+		TextureCache* mCache;
+		std::string mFileName;
+		// Unique per entry, handed out in creation order
+		uint32_t mId;
+		SDL_Texture* mTexture;
+		int mWidth;
+		int mHeight;
+		// Area of mTexture to draw (whole texture unless it's on an atlas page)
+		SDL_Rect mSrcRect;
+		// Atlas page this lives on (the page owns the texture)
+		Entry* mPage;
+		size_t mBytes;
+		std::atomic<int> mRefCount;
+		// Waiting on the loader (holds a reference of its own until uploaded)
+		bool mPending;
+		// Position in mUnused while nothing references it
+		std::list<Entry*>::iterator mUnusedPos;
+		bool mUnused;
+	};
+
+	Entry* CreateEntry(const std::string& fileName);
+	// Takes ownership of surf
+	bool Upload(Entry* entry, SDL_Surface* surf, bool premultiplied = false);
+	// Straight from the bundle's mapped pixels
+	bool UploadImage(Entry* entry, const AssetBundle::Image& image);
+	void UploadDecoded(AssetLoader::DecodedImage& image);
+	void AddRef(Entry* entry);
+	void Release(Entry* entry);
+	// Put an entry with no references on the unused list (mUnusedMutex held)
+	void MarkUnused(Entry* entry);
+	// Destroys textures, so only from the main thread
+	void EvictToBudget();
+	void Destroy(Entry* entry);
+
+	SDL_Renderer* mRenderer;
+	// Renderer supports mPremultipliedBlend
+	bool mPremultipliedSupported;
+	SDL_BlendMode mPremultipliedBlend;
+	AssetBundle mBundle;
+	std::unordered_map<std::string, Entry*> mEntries;
+	// Id for the next entry created
+	uint32_t mNextId;
+	// Unreferenced entries, least recently used at the front
+	std::list<Entry*> mUnused;
+	// Guards mUnused, handles may hit zero references on a job thread
+	std::mutex mUnusedMutex;
+	size_t mBudget;
+	Stats mStats;
+
+	AssetLoader mLoader;
+	// Reused between ProcessUploads calls
+	std::vector<AssetLoader::DecodedImage> mDecoded;
+};
+
+// Reference counted handle to a cached texture
+class TextureHandle
+{
+public:
+	TextureHandle() : mEntry(nullptr) {};
+	TextureHandle(const TextureHandle& other);
+	TextureHandle(TextureHandle&& other) noexcept;
+	TextureHandle& operator=(const TextureHandle& other);
+	TextureHandle& operator=(TextureHandle&& other) noexcept;
+	~TextureHandle();
+
+	SDL_Texture* Get() const { return mEntry ? mEntry->mTexture : nullptr; };
+	int GetWidth() const { return mEntry ? mEntry->mWidth : 0; };
+	int GetHeight() const { return mEntry ? mEntry->mHeight : 0; };
+	// Area of the texture to draw from
+	const SDL_Rect* GetSrcRect() const { return mEntry ? &mEntry->mSrcRect : nullptr; };
+	// Stable id for grouping draws that can batch: atlas sub-textures share their
+	// page's, and it's set before an async load finishes (0 for an empty handle)
+	uint32_t GetBatchId() const { return mEntry ? (mEntry->mPage ? mEntry->mPage->mId : mEntry->mId) : 0; };
+	// Size of the whole texture (the atlas page for sub-textures)
+	int GetTextureWidth() const;
+	int GetTextureHeight() const;
+	// Still waiting on an async load
+	bool IsPending() const { return mEntry && mEntry->mPending; };
+
+	explicit operator bool() const { return Get() != nullptr; };
+	bool operator==(const TextureHandle& other) const { return mEntry == other.mEntry; };
+	bool operator!=(const TextureHandle& other) const { return mEntry != other.mEntry; };
+
+	void Reset();
+
+private:
+	friend class TextureCache;
+	explicit TextureHandle(TextureCache::Entry* entry);
+
+	TextureCache::Entry* mEntry;
+};
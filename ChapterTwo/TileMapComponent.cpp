@@ -1,29 +1,490 @@
 #include "TileMapComponent.h"
-#include <fstream>
-#include <string>
-#include <sstream>
+#include "Actor.h"
+#include "Game.h"
+#include "SpriteBatch.h"
+#include "Profiler.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+	const char MapMagic[4] = { 'G', 'P', 'T', 'M' };
+	const uint32_t MapVersion = 1;
+	// Chunk textures kept by default (32 chunks of 16x16 32 pixel tiles)
+	const size_t DefaultChunkBudget = 32 * 1024 * 1024;
+
+	// Binary map layout: MapHeader then mWidth * mHeight int16_t tiles, row by row
+	struct MapHeader {
+		char mMagic[4];
+		uint32_t mVersion;
+		uint32_t mWidth;
+		uint32_t mHeight;
+	};
+}
 
 TileMapComponent::TileMapComponent(Actor* owner, int drawOrder)
 	: SpriteComponent(owner, drawOrder)
+	, mTiles(nullptr)
+	, mMapWidth(0)
+	, mMapHeight(0)
+	, mTileWidth(0)
+	, mTileHeight(0)
+	, mTilesDrawn(0)
+	, mChunkCaching(false)
+	, mChunkBytes(0)
+	, mChunkBudget(DefaultChunkBudget)
+	, mDrawCount(0)
+	, mChunksDrawn(0)
+	, mChunksBaked(0)
 {}
 
-void TileMapComponent::LoadMap(const char* csv_file) {
-	std::vector<int> row;
-	std::string line, val;
+TileMapComponent::~TileMapComponent() {
+	ClearChunks();
+}
+
+void TileMapComponent::Draw(SpriteBatch* batch) {
+	PROFILE_SCOPE("TileMapComponent::Draw");
+	mTilesDrawn = 0;
+	mChunksDrawn = 0;
+	mChunksBaked = 0;
+	mDrawCount++;
+
+	// Tile set may still be loading
+	if (!mTiles || !mTileSet || mTileWidth <= 0 || mTileHeight <= 0) {
+		return;
+	}
+
+	float scale = mOwner->GetScale();
+	float tileW = mTileWidth * scale;
+	float tileH = mTileHeight * scale;
+	if (tileW <= 0.0f || tileH <= 0.0f) {
+		return;
+	}
+	// Map's top left in screen space
+	const Camera* camera = mOwner->GetGame()->GetCamera();
+	const Vector2& cameraPos = camera->GetPosition();
+	Vector2 origin = mOwner->GetDrawPosition() - Vector2{ std::floor(cameraPos.x), std::floor(cameraPos.y) };
+	const Vector2& view = camera->GetViewSize();
+
+	// Range of tiles overlapping the view
+	int firstX = static_cast<int>(Math::Clamp(std::floor(-origin.x / tileW), 0.0f, static_cast<float>(mMapWidth)));
+	int lastX = static_cast<int>(Math::Clamp(std::ceil((view.x - origin.x) / tileW), 0.0f, static_cast<float>(mMapWidth)));
+	int firstY = static_cast<int>(Math::Clamp(std::floor(-origin.y / tileH), 0.0f, static_cast<float>(mMapHeight)));
+	int lastY = static_cast<int>(Math::Clamp(std::ceil((view.y - origin.y) / tileH), 0.0f, static_cast<float>(mMapHeight)));
+
+	if (mChunkCaching) {
+		if (DrawChunks(batch, origin, tileW, tileH, firstX, lastX, firstY, lastY)) {
+			EvictChunks();
+			return;
+		}
+
+		SDL_Log("TileMap: render targets or premultiplied blending unavailable, drawing tiles instead of chunks");
+		SetChunkCaching(false);
+	}
+
+	DrawTiles(batch, origin, tileW, tileH, firstX, lastX, firstY, lastY);
+}
+
+bool TileMapComponent::Cull(Camera* camera) {
+	if (!mTiles || mTileWidth <= 0 || mTileHeight <= 0) {
+		return false;
+	}
+
+	float scale = mOwner->GetScale();
+	const Vector2& origin = mOwner->GetDrawPosition();
+	SDL_Rect bounds{
+		static_cast<int>(std::floor(origin.x)),
+		static_cast<int>(std::floor(origin.y)),
+		static_cast<int>(std::ceil(mMapWidth * mTileWidth * scale)) + 1,
+		static_cast<int>(std::ceil(mMapHeight * mTileHeight * scale)) + 1
+	};
+	return !camera->Submit(bounds);
+}
+
+void TileMapComponent::DrawTiles(SpriteBatch* batch, const Vector2& origin, float tileW, float tileH,
+	int firstX, int lastX, int firstY, int lastY)
+{
+	int columns = mTileSet.GetWidth() / mTileWidth;
+	int numTiles = columns * (mTileSet.GetHeight() / mTileHeight);
+
+	for (int y = firstY; y < lastY; y++) {
+		const int16_t* row = mTiles + static_cast<size_t>(y) * mMapWidth;
+
+		// Edges come from the tile's own corners so neighbours never leave a gap
+		int top = static_cast<int>(origin.y + y * tileH);
+		int bottom = static_cast<int>(origin.y + (y + 1) * tileH);
+
+		for (int x = firstX; x < lastX; x++) {
+			int tile = row[x];
+			if (tile < 0 || tile >= numTiles) {
+				continue;
+			}
+
+			int left = static_cast<int>(origin.x + x * tileW);
+			int right = static_cast<int>(origin.x + (x + 1) * tileW);
+
+			SDL_Rect src{ (tile % columns) * mTileWidth, (tile / columns) * mTileHeight, mTileWidth, mTileHeight };
+			SDL_Rect dest{ left, top, right - left, bottom - top };
+			batch->Draw(mTileSet, src, dest);
+			mTilesDrawn++;
+		}
+	}
+}
+
+bool TileMapComponent::DrawChunks(SpriteBatch* batch, const Vector2& origin, float tileW, float tileH,
+	int firstX, int lastX, int firstY, int lastY)
+{
+	SDL_Renderer* renderer = batch->GetRenderer();
+	if (!renderer || !SDL_RenderTargetSupported(renderer)) {
+		return false;
+	}
+	// Chunks hold premultiplied pixels, which straight alpha blending would
+	// darken around the edge of every tile
+	if (!mOwner->GetGame()->GetTextureCache()->IsPremultipliedSupported()) {
+		return false;
+	}
+
+	// Chunks are blitted straight to the renderer, so submit anything queued before them
+	batch->Flush();
+
+	if (firstX >= lastX || firstY >= lastY) {
+		return true;
+	}
+
+	int chunksPerRow = (mMapWidth + ChunkSize - 1) / ChunkSize;
+	float chunkW = tileW * ChunkSize;
+	float chunkH = tileH * ChunkSize;
 
-	std::fstream file(csv_file, std::ios::in);
-	if (file.is_open()) {
-		while (std::getline(file, line)) {
-			row.clear();
-			std::stringstream str(line);
+	for (int chunkY = firstY / ChunkSize; chunkY <= (lastY - 1) / ChunkSize; chunkY++) {
+		int top = static_cast<int>(origin.y + chunkY * chunkH);
+		int bottom = static_cast<int>(origin.y + (chunkY + 1) * chunkH);
 
-			while (std::getline(str, val, ',')) {
-				row.push_back(std::stoi(val));
+		for (int chunkX = firstX / ChunkSize; chunkX <= (lastX - 1) / ChunkSize; chunkX++) {
+			int key = chunkY * chunksPerRow + chunkX;
+			auto iter = mChunks.find(key);
+			if (iter == mChunks.end()) {
+				Chunk chunk;
+				chunk.mTexture = nullptr;
+				chunk.mDirty = true;
+				chunk.mLastDrawn = 0;
+				chunk.mLRUPos = mChunkLRU.insert(mChunkLRU.end(), key);
+				iter = mChunks.emplace(key, chunk).first;
 			}
-			mTileMap->push_back(row);
+
+			Chunk& chunk = iter->second;
+			if (chunk.mDirty && !BakeChunk(batch, chunkX, chunkY, chunk)) {
+				return false;
+			}
+
+			// Most recently drawn goes to the back
+			chunk.mLastDrawn = mDrawCount;
+			mChunkLRU.splice(mChunkLRU.end(), mChunkLRU, chunk.mLRUPos);
+
+			int left = static_cast<int>(origin.x + chunkX * chunkW);
+			int right = static_cast<int>(origin.x + (chunkX + 1) * chunkW);
+			SDL_Rect dest{ left, top, right - left, bottom - top };
+			SDL_RenderCopy(renderer, chunk.mTexture, nullptr, &dest);
+			mChunksDrawn++;
+		}
+	}
+
+	return true;
+}
+
+bool TileMapComponent::BakeChunk(SpriteBatch* batch, int chunkX, int chunkY, Chunk& chunk) {
+	PROFILE_SCOPE("TileMapComponent::BakeChunk");
+	SDL_Renderer* renderer = batch->GetRenderer();
+	int width = ChunkSize * mTileWidth;
+	int height = ChunkSize * mTileHeight;
+
+	if (!chunk.mTexture) {
+		chunk.mTexture = SDL_CreateTexture(
+			renderer,
+			SDL_PIXELFORMAT_RGBA8888,
+			SDL_TEXTUREACCESS_TARGET,
+			width,
+			height
+		);
+		if (!chunk.mTexture) {
+			SDL_Log("Failed to create chunk texture: %s", SDL_GetError());
+			return false;
+		}
+
+		// Tiles alpha blended onto a clear target leave premultiplied pixels
+		mOwner->GetGame()->GetTextureCache()->SetBlendMode(chunk.mTexture, true);
+		mChunkBytes += static_cast<size_t>(width) * height * 4;
+	}
+
+	SDL_Texture* target = SDL_GetRenderTarget(renderer);
+	Uint8 r, g, b, a;
+	SDL_GetRenderDrawColor(renderer, &r, &g, &b, &a);
+
+	SDL_SetRenderTarget(renderer, chunk.mTexture);
+	SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+	SDL_RenderClear(renderer);
+
+	// Same as drawing the tiles with the chunk's corner at the origin, unscaled
+	int firstX = chunkX * ChunkSize;
+	int firstY = chunkY * ChunkSize;
+	Vector2 origin{ static_cast<float>(-firstX * mTileWidth), static_cast<float>(-firstY * mTileHeight) };
+	DrawTiles(
+		batch,
+		origin,
+		static_cast<float>(mTileWidth),
+		static_cast<float>(mTileHeight),
+		firstX,
+		Math::Min(firstX + ChunkSize, mMapWidth),
+		firstY,
+		Math::Min(firstY + ChunkSize, mMapHeight)
+	);
+	batch->Flush();
+
+	SDL_SetRenderTarget(renderer, target);
+	SDL_SetRenderDrawColor(renderer, r, g, b, a);
+
+	chunk.mDirty = false;
+	mChunksBaked++;
+	return true;
+}
+
+void TileMapComponent::EvictChunks() {
+	while (mChunkBytes > mChunkBudget && !mChunkLRU.empty()) {
+		auto iter = mChunks.find(mChunkLRU.front());
+		Chunk& chunk = iter->second;
+		// Everything left was on screen this frame
+		if (chunk.mLastDrawn == mDrawCount) {
+			break;
+		}
+
+		if (chunk.mTexture) {
+			SDL_DestroyTexture(chunk.mTexture);
+			mChunkBytes -= static_cast<size_t>(ChunkSize * mTileWidth) * ChunkSize * mTileHeight * 4;
 		}
+		mChunkLRU.pop_front();
+		mChunks.erase(iter);
 	}
-	else {
-		SDL_Log("Could not load TileMap: %s", csv_file);
+}
+
+void TileMapComponent::ClearChunks() {
+	for (auto& iter : mChunks) {
+		if (iter.second.mTexture) {
+			SDL_DestroyTexture(iter.second.mTexture);
+		}
 	}
-}
\ No newline at end of file
+	mChunks.clear();
+	mChunkLRU.clear();
+	mChunkBytes = 0;
+}
+
+bool TileMapComponent::LoadMap(const std::string& fileName) {
+	ClearChunks();
+	mTiles = nullptr;
+	mMapWidth = 0;
+	mMapHeight = 0;
+	mOwnedTiles.clear();
+
+	if (!mMapFile.Open(fileName)) {
+		SDL_Log("Could not load TileMap: %s", fileName.c_str());
+		return false;
+	}
+
+	const uint8_t* data = mMapFile.GetData();
+	size_t size = mMapFile.GetSize();
+
+	// Converted maps are used straight from the mapping
+	const MapHeader* header = reinterpret_cast<const MapHeader*>(data);
+	if (size >= sizeof(MapHeader) && memcmp(header->mMagic, MapMagic, sizeof(MapMagic)) == 0) {
+		uint64_t numTiles = static_cast<uint64_t>(header->mWidth) * header->mHeight;
+		if (header->mVersion != MapVersion
+			|| header->mWidth > INT32_MAX
+			|| header->mHeight > INT32_MAX
+			|| size < sizeof(MapHeader) + numTiles * sizeof(int16_t))
+		{
+			SDL_Log("Not a valid TileMap: %s", fileName.c_str());
+			mMapFile.Close();
+			return false;
+		}
+
+		mTiles = reinterpret_cast<const int16_t*>(data + sizeof(MapHeader));
+		mMapWidth = static_cast<int>(header->mWidth);
+		mMapHeight = static_cast<int>(header->mHeight);
+		return true;
+	}
+
+	// Anything else is parsed as CSV, the mapping is only needed while parsing
+	bool parsed = ParseCSV(reinterpret_cast<const char*>(data), size, mMapWidth, mMapHeight, mOwnedTiles);
+	mMapFile.Close();
+	if (!parsed) {
+		SDL_Log("Could not parse TileMap: %s", fileName.c_str());
+		mMapWidth = 0;
+		mMapHeight = 0;
+		mOwnedTiles.clear();
+		return false;
+	}
+
+	mTiles = mOwnedTiles.data();
+	return true;
+}
+
+void TileMapComponent::SetTileSet(const TextureHandle& tileSet, int tileWidth, int tileHeight) {
+	// Chunk textures are sized by the tiles
+	ClearChunks();
+	mTileSet = tileSet;
+	mTileWidth = tileWidth;
+	mTileHeight = tileHeight;
+}
+
+void TileMapComponent::SetTile(int x, int y, int tile) {
+	if (x < 0 || x >= mMapWidth || y < 0 || y >= mMapHeight) {
+		return;
+	}
+
+	// Mapped tiles are read only, take a copy to edit
+	if (mMapFile.IsOpen()) {
+		mOwnedTiles.assign(mTiles, mTiles + static_cast<size_t>(mMapWidth) * mMapHeight);
+		mTiles = mOwnedTiles.data();
+		mMapFile.Close();
+	}
+
+	mOwnedTiles[static_cast<size_t>(y) * mMapWidth + x] = static_cast<int16_t>(tile);
+
+	int chunksPerRow = (mMapWidth + ChunkSize - 1) / ChunkSize;
+	auto iter = mChunks.find((y / ChunkSize) * chunksPerRow + x / ChunkSize);
+	if (iter != mChunks.end()) {
+		iter->second.mDirty = true;
+	}
+}
+
+void TileMapComponent::SetChunkCaching(bool cache) {
+	mChunkCaching = cache;
+	if (!cache) {
+		ClearChunks();
+	}
+}
+
+void TileMapComponent::SetChunkBudget(size_t bytes) {
+	mChunkBudget = bytes;
+	EvictChunks();
+}
+
+bool TileMapComponent::ConvertMap(const std::string& csvFile, const std::string& mapFile) {
+	MappedFile csv;
+	if (!csv.Open(csvFile)) {
+		SDL_Log("Could not load TileMap: %s", csvFile.c_str());
+		return false;
+	}
+
+	int width = 0;
+	int height = 0;
+	std::vector<int16_t> tiles;
+	if (!ParseCSV(reinterpret_cast<const char*>(csv.GetData()), csv.GetSize(), width, height, tiles)) {
+		SDL_Log("Could not parse TileMap: %s", csvFile.c_str());
+		return false;
+	}
+	csv.Close();
+
+	FILE* file = fopen(mapFile.c_str(), "wb");
+	if (!file) {
+		SDL_Log("Failed to open TileMap for writing: %s", mapFile.c_str());
+		return false;
+	}
+
+	MapHeader header = {};
+	memcpy(header.mMagic, MapMagic, sizeof(MapMagic));
+	header.mVersion = MapVersion;
+	header.mWidth = static_cast<uint32_t>(width);
+	header.mHeight = static_cast<uint32_t>(height);
+	fwrite(&header, sizeof(header), 1, file);
+	fwrite(tiles.data(), sizeof(int16_t), tiles.size(), file);
+
+	bool ok = ferror(file) == 0;
+	fclose(file);
+
+	SDL_Log("TileMap %s: %d x %d tiles", mapFile.c_str(), width, height);
+
+	return ok;
+}
+
+bool TileMapComponent::ParseCSV(const char* text, size_t length, int& width, int& height, std::vector<int16_t>& tiles) {
+	const char* p = text;
+	const char* end = text + length;
+
+	width = 0;
+	height = 0;
+	tiles.clear();
+	// Every cell takes at least two characters ("0,")
+	tiles.reserve(length / 2 + 1);
+
+	while (p < end) {
+		// One row, one value per comma separated cell
+		int columns = 0;
+		bool blank = true;
+		while (true) {
+			while (p < end && (*p == ' ' || *p == '\t')) {
+				p++;
+			}
+
+			bool negative = p < end && *p == '-';
+			if (negative) {
+				p++;
+			}
+
+			int value = 0;
+			bool digits = false;
+			while (p < end && *p >= '0' && *p <= '9') {
+				value = value * 10 + (*p - '0');
+				if (value > INT16_MAX) {
+					SDL_Log("TileMap row %d: tile index too large", height + 1);
+					return false;
+				}
+				digits = true;
+				p++;
+			}
+
+			while (p < end && (*p == ' ' || *p == '\t')) {
+				p++;
+			}
+
+			// Empty cells have no tile
+			tiles.emplace_back(static_cast<int16_t>(digits ? (negative ? -value : value) : EmptyTile));
+			columns++;
+			blank = blank && !digits && !negative;
+
+			if (p < end && *p == ',') {
+				p++;
+				blank = false;
+				continue;
+			}
+			break;
+		}
+
+		if (p < end && *p == '\r') {
+			p++;
+		}
+		if (p < end && *p == '\n') {
+			p++;
+		}
+		else if (p < end) {
+			SDL_Log("TileMap row %d: unexpected character '%c'", height + 1, *p);
+			return false;
+		}
+
+		// Skip blank lines (usually a trailing newline)
+		if (blank) {
+			tiles.pop_back();
+			continue;
+		}
+
+		if (height == 0) {
+			width = columns;
+		}
+		else if (columns != width) {
+			SDL_Log("TileMap row %d has %d tiles, expected %d", height + 1, columns, width);
+			return false;
+		}
+		height++;
+	}
+
+	return width > 0;
+}
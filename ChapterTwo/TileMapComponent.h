@@ -1,16 +1,114 @@
 #pragma once
 #include "SpriteComponent.h"
+#include "MappedFile.h"
+#include "Math.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
+// Grid of tiles drawn from a tile set texture, with the owner's position
+// as the map's top left corner on screen.
+// The tiles are one flat row major array of tile set indices (-1 for none).
+// Maps load from CSV, or from the binary format ConvertMap writes, which is
+// memory mapped and used in place so even huge maps load instantly.
+// Only tiles overlapping the screen are drawn, so the cost of a frame
+// depends on the screen size rather than the map size.
+// Static layers can cache chunks of ChunkSize x ChunkSize tiles in render
+// target textures, then a frame only blits the few chunks on screen.
 class TileMapComponent : public SpriteComponent {
 public:
-	TileMapComponent(Actor* owner, int drawOrder);
+	OBJECT_POOL(TileMapComponent)
+	TileMapComponent(Actor* owner, int drawOrder = 10);
+	~TileMapComponent();
 
-	void Draw(SDL_Renderer* renderer) override;
-	// Read a csv file and place the values into a 2D array
-	void LoadMap(const char* csv_file);
+	void Draw(class SpriteBatch* batch) override;
+	// Culled as a whole when the map is off screen, Draw skips off screen tiles
+	bool Cull(class Camera* camera) override;
+
+	// Load a CSV map or a converted one (told apart by the header)
+	bool LoadMap(const std::string& fileName);
+	// Tile set is cut into tileWidth x tileHeight tiles, numbered left to right, top to bottom
+	void SetTileSet(const TextureHandle& tileSet, int tileWidth, int tileHeight);
+
+	// Change a tile (a mapped map is copied the first time, the file is read only)
+	void SetTile(int x, int y, int tile);
+
+	// Draw through cached chunk textures (falls back to tiles without render targets)
+	void SetChunkCaching(bool cache);
+	// Bytes of chunk textures kept around, the least recently drawn go first
+	// (Chunks on screen are always kept)
+	void SetChunkBudget(size_t bytes);
+	size_t GetChunkBytes() const { return mChunkBytes; };
+
+	// Parse a CSV map and write it out in the binary format
+	static bool ConvertMap(const std::string& csvFile, const std::string& mapFile);
+
+	int GetMapWidth() const { return mMapWidth; };
+	int GetMapHeight() const { return mMapHeight; };
+	int GetTile(int x, int y) const { return mTiles[static_cast<size_t>(y) * mMapWidth + x]; };
+	// Tiles queued by the last Draw (including tiles baked into chunks)
+	int GetTilesDrawn() const { return mTilesDrawn; };
+	// Chunks blitted / re-baked by the last Draw
+	int GetChunksDrawn() const { return mChunksDrawn; };
+	int GetChunksBaked() const { return mChunksBaked; };
+
+	static const int16_t EmptyTile = -1;
+	// Chunk edge length in tiles
+	static const int ChunkSize = 16;
 
 private:
-	std::vector<std::vector<int>>* mTileMap;
-	SDL_Texture* mTileSet;
-};
\ No newline at end of file
+	struct Chunk {
+		SDL_Texture* mTexture;
+		// A tile in it changed since it was baked
+		bool mDirty;
+		// Draw call it was last on screen for
+		int mLastDrawn;
+		// Position in mChunkLRU
+		std::list<int>::iterator mLRUPos;
+	};
+
+	// Queue the tiles in [firstX, lastX) x [firstY, lastY) with the map's
+	// top left corner at origin
+	void DrawTiles(class SpriteBatch* batch, const Vector2& origin, float tileW, float tileH,
+		int firstX, int lastX, int firstY, int lastY);
+	// Blit the chunks in range, baking any that are missing or dirty
+	// (false if render targets or premultiplied blending can't be used)
+	bool DrawChunks(class SpriteBatch* batch, const Vector2& origin, float tileW, float tileH,
+		int firstX, int lastX, int firstY, int lastY);
+	bool BakeChunk(class SpriteBatch* batch, int chunkX, int chunkY, Chunk& chunk);
+	// Drop least recently drawn chunks until back under budget
+	void EvictChunks();
+	void ClearChunks();
+
+	// One value per cell, every row the same length
+	static bool ParseCSV(const char* text, size_t length, int& width, int& height, std::vector<int16_t>& tiles);
+
+	// Tiles in row major order, points into mOwnedTiles or mMapFile
+	const int16_t* mTiles;
+	int mMapWidth;
+	int mMapHeight;
+	// Tiles parsed from a CSV
+	std::vector<int16_t> mOwnedTiles;
+	// Binary map, mapped for as long as it's in use
+	MappedFile mMapFile;
+
+	TextureHandle mTileSet;
+	int mTileWidth;
+	int mTileHeight;
+
+	int mTilesDrawn;
+
+	bool mChunkCaching;
+	// Chunks by chunkY * chunks per row + chunkX
+	std::unordered_map<int, Chunk> mChunks;
+	// Chunk keys, least recently drawn at the front
+	std::list<int> mChunkLRU;
+	size_t mChunkBytes;
+	size_t mChunkBudget;
+	int mDrawCount;
+	int mChunksDrawn;
+	int mChunksBaked;
+};
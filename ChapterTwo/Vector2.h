@@ -1,3 +1,3 @@
 #pragma once
-
-
+// Vector2 lives in Math.h with the rest of the math types
+#include "Math.h"
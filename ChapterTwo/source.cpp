@@ -1,14 +1,170 @@
 #include "Game.h"
+#include "Benchmark.h"
+#include "Profiler.h"
+#include "AssetBundle.h"
+#include "TileMapComponent.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
 
 int main(int argc, char* args[]) {
+	// --bench runs the headless benchmarks instead of the game
+	// (--bench-json <file> also writes the results out as JSON)
+	bool bench = false;
+	const char* benchJson = nullptr;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(args[i], "--bench") == 0) {
+			bench = true;
+		}
+		else if (strcmp(args[i], "--bench-json") == 0 && i + 1 < argc) {
+			bench = true;
+			benchJson = args[++i];
+		}
+	}
+	if (bench) {
+		return Benchmark::RunAll(benchJson) ? 0 : 1;
+	}
+
+	// --bundle <file> packs every PNG under Assets/ into an asset bundle
+	for (int i = 1; i + 1 < argc; i++) {
+		if (strcmp(args[i], "--bundle") == 0) {
+			// (error_code overloads, a missing Assets/ shouldn't throw out of main)
+			std::error_code error;
+			std::filesystem::recursive_directory_iterator iter("Assets", error);
+			if (error) {
+				SDL_Log("Failed to read Assets/ for the bundle: %s", error.message().c_str());
+				return 1;
+			}
+
+			std::vector<std::string> images;
+			for (; iter != std::filesystem::recursive_directory_iterator(); iter.increment(error)) {
+				if (error) {
+					SDL_Log("Failed to read Assets/ for the bundle: %s", error.message().c_str());
+					return 1;
+				}
+				if (iter->is_regular_file(error) && iter->path().extension() == ".png") {
+					// Same names the game asks the texture cache for
+					images.emplace_back(iter->path().generic_string());
+				}
+			}
+			std::sort(images.begin(), images.end());
+
+			return AssetBundle::Build(args[i + 1], images) ? 0 : 1;
+		}
+	}
+
+	// --convert-map <csv> <map> writes a CSV tile map out in the binary format
+	for (int i = 1; i + 2 < argc; i++) {
+		if (strcmp(args[i], "--convert-map") == 0) {
+			return TileMapComponent::ConvertMap(args[i + 1], args[i + 2]) ? 0 : 1;
+		}
+	}
+
 	Game game;
+
+	// Headless options:
+	//   --headless <frames>  run that many frames with no window and exit
+	//   --dt <seconds>       fixed delta time per frame (default 1/60)
+	//   --render             still draw into the offscreen surface
+	//   --fps <rate>         frame rate limit when windowed (0 for uncapped)
+	//   --sim-rate <hz>      fixed simulation steps per second (default 60)
+	//   --threads <n>        threads for actor updates (default one per core)
+	//   --profile <file>     record profiler zones, log a summary and write
+	//                        a Chrome trace to file on exit
+	// Input logs:
+	//   --record <file>      save the keyboard and frame times to file
+	//   --replay <file>      play a recording back headlessly (every frame of
+	//                        it, unless --headless says how many), exits with 1
+	//                        if the game state ever differs from the recording
+	int headlessFrames = 0;
+	const char* traceFile = nullptr;
+	const char* recordFile = nullptr;
+	const char* replayFile = nullptr;
+	float fixedDeltaTime = 0.0f;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(args[i], "--headless") == 0 && i + 1 < argc) {
+			headlessFrames = atoi(args[++i]);
+			game.SetHeadless(true);
+		}
+		else if (strcmp(args[i], "--dt") == 0 && i + 1 < argc) {
+			fixedDeltaTime = static_cast<float>(atof(args[++i]));
+		}
+		else if (strcmp(args[i], "--render") == 0) {
+			game.SetHeadlessRendering(true);
+		}
+		else if (strcmp(args[i], "--fps") == 0 && i + 1 < argc) {
+			game.SetTargetFPS(static_cast<float>(atof(args[++i])));
+		}
+		else if (strcmp(args[i], "--sim-rate") == 0 && i + 1 < argc) {
+			float hz = static_cast<float>(atof(args[++i]));
+			if (hz > 0.0f) {
+				game.SetSimRate(hz);
+			}
+		}
+		else if (strcmp(args[i], "--threads") == 0 && i + 1 < argc) {
+			game.SetNumThreads(atoi(args[++i]));
+		}
+		else if (strcmp(args[i], "--profile") == 0 && i + 1 < argc) {
+			traceFile = args[++i];
+			Profiler::SetEnabled(true);
+		}
+		else if (strcmp(args[i], "--record") == 0 && i + 1 < argc) {
+			recordFile = args[++i];
+		}
+		else if (strcmp(args[i], "--replay") == 0 && i + 1 < argc) {
+			replayFile = args[++i];
+			game.SetHeadless(true);
+		}
+	}
+
+	// After the options, the log needs the final sim rate
+	if (replayFile) {
+		if (!game.StartReplay(replayFile)) {
+			return 1;
+		}
+		if (headlessFrames <= 0) {
+			headlessFrames = game.GetInputLog()->GetNumFrames();
+		}
+	}
+	else if (recordFile && !game.StartRecording(recordFile)) {
+		return 1;
+	}
+
+	if (game.IsHeadless() && fixedDeltaTime <= 0.0f) {
+		fixedDeltaTime = 1.0f / 60.0f;
+	}
+	game.SetFixedDeltaTime(fixedDeltaTime);
+
 	bool success = game.Initialise();
 
 	if (success) {
-		game.RunLoop();
+		if (game.IsHeadless()) {
+			Uint64 start = SDL_GetPerformanceCounter();
+			game.RunFrames(headlessFrames);
+			double seconds = static_cast<double>(SDL_GetPerformanceCounter() - start)
+				/ SDL_GetPerformanceFrequency();
+
+			SDL_Log("Headless: %d frames in %.3f s (%.1f frames/s)",
+				game.GetFrameCount(),
+				seconds,
+				seconds > 0.0 ? game.GetFrameCount() / seconds : 0.0
+			);
+		}
+		else {
+			game.RunLoop();
+		}
+	}
+
+	if (traceFile) {
+		Profiler::LogSummary();
+		Profiler::WriteChromeTrace(traceFile);
 	}
 
+	int mismatches = game.GetInputLog()->GetMismatches();
 	game.Shutdown();
 
-	return 0;
+	return mismatches > 0 ? 1 : 0;
 }
\ No newline at end of file